@@ -116,6 +116,9 @@ void ActionManager::CreateActions() {
   RegisterAction(ManageWorkspaces, "Manage Workspaces");
   RegisterAction(OpenWorkspace, "Open Workspace");
 
+  RegisterAction(ToggleTracing, "Record Trace");
+  RegisterAction(StartupTimings, "Startup Timings");
+
   // Default shortcuts
   auto shortcuts = [=](ActionManager::Type type, const QString& shortcuts) {
     default_shortcuts_[type] = QKeySequence::listFromString(shortcuts);
@@ -76,6 +76,9 @@ class ActionManager : public QObject {
     ManageWorkspaces,
     OpenWorkspace,
 
+    ToggleTracing,
+    StartupTimings,
+
     UserAction = 10000
   };
   Q_ENUM(Type)
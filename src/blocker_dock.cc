@@ -4,6 +4,7 @@
 #include <set>
 
 #include "main_window.h"
+#include "metrics_registry.h"
 #include "profile.h"
 
 namespace doogie {
@@ -284,7 +285,14 @@ bool BlockerDock::IsAllowedToLoad(BrowserWidget* browser,
                                          QUrl(ref_url_str, QUrl::StrictMode);
   auto type = TypeFromRequest(target_url, request);
   auto result = rules_->FindStaticRule(target_url, ref_url, type);
+  // Called from CEF's IO thread for every request, so keep it cheap
+  static auto check_time = MetricsRegistry::GetHistogram("blocker.check");
+  static auto checks = MetricsRegistry::GetCounter("blocker.checks");
+  static auto blocked = MetricsRegistry::GetCounter("blocker.blocked");
+  check_time->Record(timer.nsecsElapsed() / 1000);
+  checks->Increment();
   if (!result) return true;
+  blocked->Increment();
 
   // Add a few more details before deleting the result
   auto req_file_index = result->info.file_index;
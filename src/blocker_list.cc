@@ -2,11 +2,15 @@
 
 #include "profile.h"
 #include "sql.h"
+#include "sql_executor.h"
 
 namespace doogie {
 
+qlonglong BlockerList::next_id_ = -1;
+
 QList<BlockerList> BlockerList::Lists(QSet<qlonglong> only_ids) {
   QList<BlockerList> ret;
+  SqlExecutor::WaitFor("blocker_list");
   QSqlQuery query;
   QString sql = "SELECT * FROM blocker_list";
   if (!only_ids.isEmpty()) {
@@ -95,7 +99,6 @@ bool BlockerList::Persist() {
       return false;
     }
   }
-  QSqlQuery query;
   auto version = version_ == 0 ? QVariant(QVariant::LongLong) : version_;
   auto expiration_hours = expiration_hours_ == 0 ?
         QVariant(QVariant::Int) : expiration_hours_;
@@ -104,8 +107,7 @@ bool BlockerList::Persist() {
   auto last_refreshed = last_refreshed_.isNull() ?
         QVariant(QVariant::LongLong) : last_refreshed_.toSecsSinceEpoch();
   if (Exists()) {
-    return Sql::ExecParam(
-        &query,
+    SqlExecutor::EnqueueParam(
         "UPDATE blocker_list SET "
         "  name = ?, "
         "  homepage = ?, "
@@ -117,28 +119,30 @@ bool BlockerList::Persist() {
         "  last_known_rule_count = ? "
         "WHERE id = ?",
         { name_, homepage_, url_, local_path_, version,
-          last_refreshed, expiration_hours, last_known_rule_count, id_ });
+          last_refreshed, expiration_hours, last_known_rule_count, id_ },
+        { "blocker_list" });
+    return true;
   }
-  auto ok = Sql::ExecParam(
-      &query,
+  // Callers need the ID right away, so we pick it
+  auto id = NextId();
+  if (id < 0) return false;
+  SqlExecutor::EnqueueParam(
       "INSERT INTO blocker_list ( "
-      "  name, homepage, url, local_path, version, "
+      "  id, name, homepage, url, local_path, version, "
       "  last_refreshed, expiration_hours, last_known_rule_count "
-      ") VALUES (?, ?, ?, ?, ?, ?, ?, ?)",
-      { name_, homepage_, url_, local_path_, version,
-        last_refreshed, expiration_hours, last_known_rule_count });
-  if (!ok) return false;
-  id_ = query.lastInsertId().toLongLong();
+      ") VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)",
+      { id, name_, homepage_, url_, local_path_, version,
+        last_refreshed, expiration_hours, last_known_rule_count },
+      { "blocker_list" });
+  id_ = id;
   return true;
 }
 
 bool BlockerList::Delete() {
   if (!Exists()) return false;
-  QSqlQuery query;
-  auto ok = Sql::ExecParam(&query,
-                           "DELETE FROM blocker_list WHERE id = ?",
-                           { id_ });
-  if (!ok) return false;
+  // Queued so it can't land before our own insert
+  SqlExecutor::EnqueueParam("DELETE FROM blocker_list WHERE id = ?",
+                            { id_ }, { "blocker_list" });
   // Try to delete the local cache file if it had a url
   if (!url_.isEmpty()) {
     QFile(local_path_).remove();
@@ -148,6 +152,7 @@ bool BlockerList::Delete() {
 
 bool BlockerList::Reload() {
   if (!Exists()) return false;
+  SqlExecutor::WaitFor("blocker_list");
   QSqlQuery query;
   auto record = Sql::ExecSingleParam(
         &query,
@@ -219,6 +224,19 @@ std::function<void()> BlockerList::Update(
   });
 }
 
+qlonglong BlockerList::NextId() {
+  if (next_id_ < 0) {
+    // Only read once, after that every insert goes through here
+    SqlExecutor::WaitFor("blocker_list");
+    QSqlQuery query;
+    auto record = Sql::ExecSingle(
+          &query, "SELECT IFNULL(MAX(id), 0) FROM blocker_list");
+    if (record.isEmpty()) return -1;
+    next_id_ = record.value(0).toLongLong() + 1;
+  }
+  return next_id_++;
+}
+
 bool BlockerList::NeedsUpdate() {
   // An empty last-refreshed means we do need an update
   if (last_refreshed_.isNull()) return true;
@@ -243,53 +261,32 @@ std::function<void()> BlockerList::DownloadRules(
     int file_index,
     const QString& file_cache_to,
     std::function<void(QList<BlockerRules::Rule*>)> callback) {
-  auto buf = new QBuffer;
-  buf->open(QIODevice::ReadWrite);
-  return cef.Download(url, buf,
-                       [=](CefRefPtr<CefURLRequest> req, QIODevice* device) {
-    if (req->GetRequestStatus() != UR_SUCCESS) {
-      qWarning() << "Load of list at" << url <<
-                    "failed because non-success of download";
-      callback(QList<BlockerRules::Rule*>());
-      return;
-    }
-    // We'd do a lot better streaming this, but meh, it's not a big deal
-    auto buf = qobject_cast<QBuffer*>(device);
-    if (!buf) {
-      qWarning() << "Load of list at" << url <<
-                    "failed because device not present";
-      callback(QList<BlockerRules::Rule*>());
-      return;
-    }
-    // Put buffer back at beginning for parse
-    buf->seek(0);
-    // It's mine to delete
-    buf->deleteLater();
-    // Let's write the entire buffer to the cached file if there is one
-    if (!file_cache_to.isEmpty()) {
-      QFile file(file_cache_to);
-      if (!file.open(QIODevice::WriteOnly)) {
-        qWarning() << "Load of list at" << url <<
-                      "failed because unable to write to" << file_cache_to;
-        callback(QList<BlockerRules::Rule*>());
-        return;
-      } else {
-        file.write(buf->data());
-        file.close();
-      }
-    }
-    auto ok = false;
-    QTextStream stream(buf);
-    auto rules = BlockerRules::ParseRules(&stream, file_index, &ok);
-    if (!ok) {
-      qWarning() << "Load of list at" << url <<
-                    "failed because of parse failure";
+  // Parse as it streams in, teeing to the cached file if there is one.
+  // The file is only replaced if the whole thing succeeds.
+  auto rules = std::make_shared<QList<BlockerRules::Rule*>>();
+  auto line_num = std::make_shared<int>(0);
+  DownloadSink* sink = new LineDownloadSink(
+        [=](const QString& line) {
+    auto rule = BlockerRules::Rule::ParseRule(line, file_index, ++*line_num);
+    if (rule) rules->append(rule);
+    return true;
+  }, file_cache_to.isEmpty() ? nullptr : new FileDownloadSink(file_cache_to));
+  // Servers usually compress on the fly which CEF undoes for us, but some
+  // lists are published as .gz files
+  if (QUrl(url).path().endsWith(".gz")) {
+    sink = new InflateDownloadSink(InflateDownloadSink::GzipOrZlib, sink);
+  }
+  return cef.Download(url, sink,
+                      [=](CefRefPtr<CefURLRequest>, const QString& error) {
+    if (!error.isEmpty()) {
+      qWarning() << "Load of list at" << url << "failed:" << error;
+      qDeleteAll(*rules);
       callback(QList<BlockerRules::Rule*>());
       return;
     }
     qDebug() << "Load of list at" << url <<
-                "obtained rule count:" << rules.size();
-    callback(rules);
+                "obtained rule count:" << rules->size();
+    callback(*rules);
   });
 }
 
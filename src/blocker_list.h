@@ -88,11 +88,17 @@ class BlockerList {
       const QString& file_cache_to,
       std::function<void(QList<BlockerRules::Rule*> rules)> callback);
 
+  // IDs are handed out here instead of by SQLite so inserts never have
+  //  to wait on the writer. Only the GUI thread inserts lists.
+  static qlonglong NextId();
+
   explicit BlockerList(const QSqlRecord& record);
   void ApplySqlRecord(const QSqlRecord& record);
 
   void UpdateFromMeta(BlockerRules::ListMetadata meta);
 
+  static qlonglong next_id_;
+
   qlonglong id_ = -1;
   QString name_;
   QString homepage_;
@@ -2,6 +2,8 @@
 
 #include <iterator>
 
+#include "tracing.h"
+
 namespace std {
 
 inline uint qHash(const std::string& str) {
@@ -432,6 +434,7 @@ BlockerRules::CosmeticRule* BlockerRules::CosmeticRule::ParseRule(
 QList<BlockerRules::Rule*> BlockerRules::ParseRules(QTextStream* stream,
                                                     int file_index,
                                                     bool* parse_ok) {
+  Tracing::Span span("blocker", "ParseRules");
   QList<BlockerRules::Rule*> ret;
   int line_num = 0;
   while (!stream->atEnd()) {
@@ -510,6 +513,8 @@ bool BlockerRules::AddRules(QTextStream* stream, int file_index) {
 }
 
 void BlockerRules::AddRules(const QList<Rule*>& rules) {
+  Tracing::Span span("blocker", "AddRules",
+                     QString("%1 rules").arg(rules.size()));
   for (const auto rule : rules) {
     auto st = rule->AsStatic();
     if (st) AddStaticRule(st);
@@ -535,6 +540,7 @@ BlockerRules::StaticRule::FindResult* BlockerRules::FindStaticRule(
     const QUrl& ref_url,
     StaticRule::RequestType request_type,
     const QSet<int>& ignored_file_indexes) const {
+  Tracing::Span span("blocker", "FindStaticRule");
   // We require URLs w/ schemes and hosts
   if (!target_url.isValid() || !ref_url.isValid() ||
       target_url.scheme().isEmpty() || ref_url.scheme().isEmpty() ||
@@ -1,6 +1,9 @@
 #include "browser_widget.h"
 
 #include "page_index.h"
+#include "screenshot_cache.h"
+#include "suspended_page_view.h"
+#include "tracing.h"
 #include "util.h"
 #include "ssl_info_action.h"
 
@@ -11,6 +14,7 @@ BrowserWidget::BrowserWidget(const Cef& cef,
                              const QString& url,
                              QWidget* parent)
     : QWidget(parent), cef_(cef), bubble_(bubble) {
+  Tracing::Span span("browser", "CreateBrowserWidget", url);
 
   nav_menu_ = new QMenu(this);
   // When this menu is about to be opened we have to populate the items
@@ -274,25 +278,17 @@ void BrowserWidget::SetSuspended(bool suspend, const QString& url_override) {
   suspended_ = suspend;
   if (suspended_) {
     suspended_url_ = url_override.isNull() ? CurrentUrl() : url_override;
-    // We will make fake pixels for the rest of the screen
-    // and we will make it lighter to look disabled
-    auto screen = QGuiApplication::primaryScreen();
-    suspended_screenshot_ = QPixmap(screen->size());
-    // Only do this if this is visible
+    // Only do this if this is visible. Otherwise, whatever was stored the
+    // last time is still right since it's removed on unsuspend.
     if (cef_widg_->isVisible()) {
-      Util::LighterDisabled(screen->grabWindow(cef_widg_->winId()),
-                            &suspended_screenshot_);
+      ScreenshotCache::Store(
+            ScreenshotId(),
+            QGuiApplication::primaryScreen()->grabWindow(cef_widg_->winId()));
     }
-    QPainter painter;
-    painter.begin(&suspended_screenshot_);
-    auto font = painter.font();
-    font.setPointSize(40);
-    font.setBold(true);
-    painter.setFont(font);
-    painter.drawText(rect(), Qt::AlignCenter, "Suspended");
     // Close directly, don't call this->TryClose
     cef_widg_->TryClose();
   } else {
+    ScreenshotCache::Remove(ScreenshotId());
     emit SuspensionChanged();
     cef_widg_->LoadUrl(suspended_url_);
     cef_widg_->setFocus();
@@ -354,6 +350,7 @@ void BrowserWidget::RecreateCefWidget(const QString& url,
     cef_widg_->disconnect();
     cef_widg_->deleteLater();
   }
+  Tracing::Span span("browser", "CreateCefWidget", url);
   cef_widg_ = new CefWidget(cef_, bubble_, url, this, widg_size);
   cef_widg_->SetResourceLoadCallback(resource_load_callback_);
   connect(cef_widg_, &CefWidget::PreContextMenu,
@@ -370,7 +367,7 @@ void BrowserWidget::RecreateCefWidget(const QString& url,
     current_favicon_url_ = url;
     current_favicon_ = icon;
     emit FaviconChanged();
-    PageIndex::UpdateFavicon(CurrentUrl(), url, icon);
+    PageIndex::UpdateFavicon(CurrentUrl(), icon);
   });
   connect(cef_widg_, &CefWidget::DownloadRequested,
           this, &BrowserWidget::DownloadRequested);
@@ -399,8 +396,7 @@ void BrowserWidget::RecreateCefWidget(const QString& url,
     // TODO(cretz): Test when title/favicon is not changed or not present
     if (!is_loading) {
       auto title = current_title_.isNull() ? "" : current_title_;
-      PageIndex::MarkVisit(CurrentUrl(), title,
-                           current_favicon_url_, current_favicon_);
+      PageIndex::MarkVisit(CurrentUrl(), title, current_favicon_);
     }
 
     // Reset the stylesheet and update SSL status when not errored
@@ -587,14 +583,8 @@ void BrowserWidget::ShowAsSuspendedScreenshot() {
     // Remove the cef widg and add screenshot
     grid_layout->removeWidget(cef_widg_);
     cef_widg_->hide();
-    auto widg = new QWidget();
-    widg->setAutoFillBackground(true);
-    auto pal = widg->palette();
-    pal.setBrush(QPalette::Window, QBrush(suspended_screenshot_));
-    widg->setPalette(pal);
-    grid_layout->addWidget(widg, 1, 0);
+    grid_layout->addWidget(new SuspendedPageView(ScreenshotId()), 1, 0);
   } else {
-    suspended_screenshot_ = QPixmap();
     // Remove the screenshot and add back the cef widg
     auto item = grid_layout->itemAtPosition(1, 0);
     grid_layout->removeItem(item);
@@ -607,6 +597,10 @@ void BrowserWidget::ShowAsSuspendedScreenshot() {
   }
 }
 
+qlonglong BrowserWidget::ScreenshotId() const {
+  return screenshot_id_lookup_ ? screenshot_id_lookup_() : -1;
+}
+
 void BrowserWidget::BuildContextMenu(CefRefPtr<CefContextMenuParams> params,
                                      CefRefPtr<CefMenuModel> model) {
   if (params->GetTypeFlags() & CM_TYPEFLAG_LINK) {
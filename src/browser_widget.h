@@ -19,6 +19,8 @@ class BrowserWidget : public QWidget {
       BrowserWidget* browser,
       CefRefPtr<CefFrame> frame,
       CefRefPtr<CefRequest> request)> ResourceLoadCallback;
+  // Gives the workspace page ID, -1 if none
+  typedef std::function<qlonglong()> ScreenshotIdLookup;
 
   enum ContextMenuCommand {
     ContextMenuOpenLinkChildPage = MENU_ID_USER_FIRST,
@@ -68,6 +70,12 @@ class BrowserWidget : public QWidget {
 
   bool Suspended() const;
   void SetSuspended(bool suspend, const QString& url_override = QString());
+  // Gives the workspace page ID the suspended screenshot is stored under.
+  //  Only called when one is stored or loaded since it may wait on the
+  //  page's insert.
+  void SetScreenshotIdLookup(ScreenshotIdLookup lookup) {
+    screenshot_id_lookup_ = lookup;
+  }
 
   void SetResourceLoadCallback(ResourceLoadCallback callback);
 
@@ -109,6 +117,7 @@ class BrowserWidget : public QWidget {
   void RecreateCefWidget(const QString& url,
                          const QSize& initial_size = QSize());
   void ShowAsSuspendedScreenshot();
+  qlonglong ScreenshotId() const;
   void UpdateStatusBarLocation();
   void RebuildNavMenu();
   void BuildContextMenu(CefRefPtr<CefContextMenuParams> params,
@@ -141,7 +150,7 @@ class BrowserWidget : public QWidget {
   bool can_go_forward_ = false;
   bool suspended_ = false;
   QString suspended_url_;
-  QPixmap suspended_screenshot_;
+  ScreenshotIdLookup screenshot_id_lookup_;
   int number_of_load_completes_are_error_ = 0;
   CefRefPtr<CefSSLInfo> errored_ssl_info_;
   CefRefPtr<CefRequestCallback> errored_ssl_callback_;
@@ -41,6 +41,8 @@ Bubble Bubble::FromId(qlonglong id, bool* ok) {
 
 void Bubble::InvalidateCachedBubbles() {
   cached_bubbles_.clear();
+  // Existing browsers keep theirs, new ones get the new settings
+  pooled_contexts_.clear();
 }
 
 bool Bubble::ResetOrderIndexes() {
@@ -87,6 +89,7 @@ bool Bubble::Persist() {
 
 bool Bubble::Delete() {
   if (!Exists()) return false;
+  pooled_contexts_.remove(id_);
   QSqlQuery query;
   return Sql::ExecParam(&query,
                         "DELETE FROM bubble WHERE id = ?",
@@ -165,6 +168,26 @@ CefRefPtr<CefRequestContext> Bubble::CreateCefRequestContext() const {
   return CefRequestContext::CreateContext(settings, nullptr);
 }
 
+CefRefPtr<CefRequestContext> Bubble::AcquireCefRequestContext() const {
+  // Unpersisted bubbles have nothing to share with
+  if (!Exists()) return CreateCefRequestContext();
+  auto& pooled = pooled_contexts_[id_];
+  if (!pooled.context) pooled.context = CreateCefRequestContext();
+  pooled.ref_count++;
+  return pooled.context;
+}
+
+void Bubble::ReleaseCefRequestContext(qlonglong bubble_id,
+                                      CefRefPtr<CefRequestContext> context) {
+  auto pooled = pooled_contexts_.find(bubble_id);
+  // Could have been invalidated and replaced in the meantime
+  if (pooled == pooled_contexts_.end() || !context ||
+      !pooled->context->IsSame(context)) {
+    return;
+  }
+  if (--pooled->ref_count <= 0) pooled_contexts_.erase(pooled);
+}
+
 bool Bubble::operator==(const Bubble& other) const {
   return name_ == other.name_ &&
       icon_path_ == other.icon_path_ &&
@@ -354,5 +377,6 @@ void Bubble::RebuildIcon() {
 }
 
 QList<Bubble> Bubble::cached_bubbles_;
+QHash<qlonglong, Bubble::PooledContext> Bubble::pooled_contexts_;
 
 }  // namespace doogie
@@ -86,6 +86,13 @@ class Bubble {
       CefRequestContextSettings* settings,
       bool include_current_profile = true) const;
   CefRefPtr<CefRequestContext> CreateCefRequestContext() const;
+  // Shared by every browser in this bubble. Each acquire must have a
+  //  matching release w/ the same context, the pooled one is let go once
+  //  nobody holds it anymore. Settings changes (i.e. cache invalidation)
+  //  only affect contexts acquired afterwards.
+  CefRefPtr<CefRequestContext> AcquireCefRequestContext() const;
+  static void ReleaseCefRequestContext(
+      qlonglong bubble_id, CefRefPtr<CefRequestContext> context);
 
   bool operator==(const Bubble& other) const;
   bool operator!=(const Bubble& other) const { return !operator==(other); }
@@ -118,7 +125,14 @@ class Bubble {
   void ApplySqlRecord(const QSqlRecord& record);
   void RebuildIcon();
 
+  struct PooledContext {
+    CefRefPtr<CefRequestContext> context;
+    int ref_count = 0;
+  };
+
   static QList<Bubble> cached_bubbles_;
+  // Keyed by bubble ID
+  static QHash<qlonglong, PooledContext> pooled_contexts_;
 
   qlonglong id_ = -1;
   int order_index_ = -1;
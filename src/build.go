@@ -446,6 +446,8 @@ func copyResourcesLinux(qmakePath string, target string) error {
 	err = copyAndChmodEachToDirIfNotPresent(0644, filepath.Join(filepath.Dir(qmakePath), "../lib"), target,
 		"libQt5Core.so.5",
 		"libQt5Gui.so.5",
+		// Needed for the metrics server in release too
+		"libQt5Network.so.5",
 		"libQt5Sql.so.5",
 		"libQt5Widgets.so.5",
 		// TODO: See https://bugreports.qt.io/browse/QTBUG-53865
@@ -462,7 +464,6 @@ func copyResourcesLinux(qmakePath string, target string) error {
 	// Some DLLs are needed in debug only
 	if target == "debug" {
 		err := copyAndChmodEachToDirIfNotPresent(0644, filepath.Join(filepath.Dir(qmakePath), "../lib"), target,
-			"libQt5Network.so.5",
 			"libQt5Test.so.5",
 			"libQt5WebSockets.so.5",
 		)
@@ -535,13 +536,15 @@ func copyResourcesWindows(qmakePath string, target string) error {
 	qtDlls := []string{
 		"Qt5Core.dll",
 		"Qt5Gui.dll",
+		// Needed for the metrics server in release too
+		"Qt5Network.dll",
 		"Qt5Sql.dll",
 		"Qt5Widgets.dll",
 	}
 	// Debug libs are d.dll
 	if target == "debug" {
 		// Only need web sockets during debug
-		qtDlls = append(qtDlls, "Qt5WebSockets.dll", "Qt5Network.dll", "Qt5Test.dll")
+		qtDlls = append(qtDlls, "Qt5WebSockets.dll", "Qt5Test.dll")
 		for i := range qtDlls {
 			qtDlls[i] = strings.Replace(qtDlls[i], ".dll", "d.dll", -1)
 		}
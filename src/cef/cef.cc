@@ -2,7 +2,9 @@
 
 #include <QtGlobal>
 
+#include "metrics_registry.h"
 #include "profile.h"
+#include "startup_profile.h"
 
 namespace doogie {
 
@@ -19,25 +21,29 @@ Cef::Cef(int argc, char* argv[]) {
   }
 
   // Init the profile, which can fail early
+  StartupProfile::PhaseTimer profile_phase("profileLoad");
   if (!Profile::LoadProfileFromCommandLine(argc, argv)) {
     qCritical() << "Unable to create or load profile";
     early_exit_code_ = 2;
     return;
   }
+  profile_phase.End();
 
   CefSettings settings;
   Profile::Current().ApplyCefSettings(&settings);
+  // CEF tells us when it needs work instead of us polling it
+  settings.external_message_pump = true;
+  StartupProfile::PhaseTimer init_phase("cefInitialize");
   if (!CefInitialize(main_args, settings, app_handler_, nullptr)) {
     throw std::runtime_error("Unable to initialize CEF");
   }
 }
 
 Cef::~Cef() {
-  if (early_exit_code_ < 0) CefShutdown();
-}
-
-void Cef::Tick() const {
-  CefDoMessageLoopWork();
+  if (early_exit_code_ < 0) {
+    app_handler_->StopMessagePump();
+    CefShutdown();
+  }
 }
 
 bool Cef::IsValidUrl(const QString& url, bool allow_no_scheme) const {
@@ -52,52 +58,44 @@ bool Cef::IsValidUrl(const QString& url, bool allow_no_scheme) const {
 
 std::function<void()> Cef::Download(
     const QString& url,
-    QIODevice* write_to,
-    std::function<void(CefRefPtr<CefURLRequest> request,
-                       QIODevice* device)> download_complete,
+    DownloadSink* sink,
     std::function<void(CefRefPtr<CefURLRequest> request,
-                       QIODevice* device)> download_data,
+                       const QString& error)> download_complete,
     std::function<void(CefRefPtr<CefURLRequest> request,
                        uint64 current,
                        uint64 total)> download_progress) const {
   auto req = CefRequest::Create();
   req->SetURL(CefString(url.toStdString()));
-  return Download(req, write_to, download_complete,
-                  download_data, download_progress);
+  return Download(req, sink, download_complete, download_progress);
 }
 
 std::function<void()> Cef::Download(
     CefRefPtr<CefRequest> request,
-    QIODevice* write_to,
+    DownloadSink* sink,
     std::function<void(CefRefPtr<CefURLRequest> request,
-                       QIODevice* device)> download_complete,
-    std::function<void(CefRefPtr<CefURLRequest> request,
-                       QIODevice* device)> download_data,
+                       const QString& error)> download_complete,
     std::function<void(CefRefPtr<CefURLRequest> request,
                        uint64 current,
                        uint64 total)> download_progress) const {
-  CefRefPtr<Cef::CallbackFullDownload> client = new CallbackFullDownload(
-      write_to, download_complete, download_data, download_progress);
+  CefRefPtr<Cef::SinkDownload> client = new SinkDownload(
+      sink, download_complete, download_progress);
   auto url_req = CefURLRequest::Create(request, client, nullptr);
   return [=]() { if (url_req) url_req->Cancel(); };
 }
 
-Cef::CallbackFullDownload::CallbackFullDownload(
-    QIODevice* write_to,
-    std::function<void(CefRefPtr<CefURLRequest> request,
-                       QIODevice* device)> download_complete,
+Cef::SinkDownload::SinkDownload(
+    DownloadSink* sink,
     std::function<void(CefRefPtr<CefURLRequest> request,
-                       QIODevice* device)> download_data,
+                       const QString& error)> download_complete,
     std::function<void(CefRefPtr<CefURLRequest> request,
                        uint64 current,
                        uint64 total)> download_progress)
-    : write_to_(write_to),
+    : sink_(sink),
       download_complete_(download_complete),
-      download_data_(download_data),
       download_progress_(download_progress) {
 }
 
-void Cef::CallbackFullDownload::OnDownloadProgress(
+void Cef::SinkDownload::OnDownloadProgress(
     CefRefPtr<CefURLRequest> request,
     int64 current,
     int64 total) {
@@ -106,23 +104,47 @@ void Cef::CallbackFullDownload::OnDownloadProgress(
   }
 }
 
-void Cef::CallbackFullDownload::OnDownloadData(
+void Cef::SinkDownload::OnDownloadData(
     CefRefPtr<CefURLRequest> request,
     const void* data,
     size_t data_length) {
-  if (write_to_) {
-    write_to_->write(static_cast<const char*>(data), data_length);
-  }
-  if (download_data_) {
-    download_data_(request, write_to_);
+  static auto bytes = MetricsRegistry::GetCounter("download.background.bytes");
+  bytes->Increment(data_length);
+  if (!sink_ || !sink_error_.isEmpty()) return;
+  if (!sink_->Write(static_cast<const char*>(data), data_length)) {
+    sink_error_ = sink_->ErrorString();
+    // No sense downloading the rest
+    request->Cancel();
   }
 }
 
-void Cef::CallbackFullDownload::OnRequestComplete(
+void Cef::SinkDownload::OnRequestComplete(
     CefRefPtr<CefURLRequest> request) {
-  if (download_complete_) {
-    download_complete_(request, write_to_);
+  auto error = sink_error_;
+  auto response = request->GetResponse();
+  if (!error.isEmpty()) {
+    // Already failed
+  } else if (request->GetRequestStatus() != UR_SUCCESS) {
+    error = QString("Request failed with error %1").
+        arg(static_cast<int>(request->GetRequestError()));
+  } else if (response && response->GetStatus() >= 400) {
+    error = QString("Request failed with HTTP status %1").
+        arg(response->GetStatus());
+  } else if (sink_ && !sink_->Finish()) {
+    error = sink_->ErrorString();
+  }
+  static auto completed =
+      MetricsRegistry::GetCounter("download.background.completed");
+  static auto failed =
+      MetricsRegistry::GetCounter("download.background.failed");
+  if (error.isEmpty()) {
+    completed->Increment();
+  } else {
+    failed->Increment();
+    if (sink_) sink_->Abort();
   }
+  if (download_complete_) download_complete_(request, error);
+  sink_.reset();
 }
 
 QByteArray Cef::CefBinToByteArray(CefRefPtr<CefBinaryValue> bin) const {
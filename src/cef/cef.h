@@ -2,9 +2,11 @@
 #define DOOGIE_CEF_H_
 
 #include <QtWidgets>
+#include <memory>
 
 #include "cef/cef_app_handler.h"
 #include "cef/cef_base.h"
+#include "download_sink.h"
 
 namespace doogie {
 
@@ -22,9 +24,6 @@ class Cef {
   // program should exit early.
   int EarlyExitCode() const { return early_exit_code_; }
 
-  // Performs a CEF tick in a message loop.
-  void Tick() const;
-
   // The main app handler.
   CefRefPtr<CefAppHandler> AppHandler() const { return app_handler_; }
 
@@ -33,23 +32,23 @@ class Cef {
   // See other Download overload.
   std::function<void()> Download(
       const QString& url,
-      QIODevice* write_to,
-      std::function<void(CefRefPtr<CefURLRequest> request,
-                         QIODevice* device)> download_complete = nullptr,
+      DownloadSink* sink,
       std::function<void(CefRefPtr<CefURLRequest> request,
-                         QIODevice* device)> download_data = nullptr,
+                         const QString& error)> download_complete = nullptr,
       std::function<void(CefRefPtr<CefURLRequest> request,
                          uint64 current,
                          uint64 total)> download_progress = nullptr) const;
 
-  // Perform a download using CEF.
+  // Perform a download using CEF, streaming the body into the sink. The
+  // download owns the sink and deletes it right after the complete
+  // callback, which gets an empty error on success. A non-success request
+  // status, an HTTP error status or a failing sink are all errors. The
+  // returned function cancels the download.
   std::function<void()> Download(
       CefRefPtr<CefRequest> request,
-      QIODevice* write_to,
-      std::function<void(CefRefPtr<CefURLRequest> request,
-                         QIODevice* device)> download_complete = nullptr,
+      DownloadSink* sink,
       std::function<void(CefRefPtr<CefURLRequest> request,
-                         QIODevice* device)> download_data = nullptr,
+                         const QString& error)> download_complete = nullptr,
       std::function<void(CefRefPtr<CefURLRequest> request,
                          uint64 current,
                          uint64 total)> download_progress = nullptr) const;
@@ -59,14 +58,12 @@ class Cef {
   bool ShowCertDialog(CefRefPtr<CefX509Certificate> cert) const;
 
  private:
-  class CallbackFullDownload : public CefURLRequestClient {
+  class SinkDownload : public CefURLRequestClient {
    public:
-    CallbackFullDownload(
-        QIODevice* write_to,
+    SinkDownload(
+        DownloadSink* sink,
         std::function<void(CefRefPtr<CefURLRequest> request,
-                           QIODevice* device)> download_complete,
-        std::function<void(CefRefPtr<CefURLRequest> request,
-                           QIODevice* device)> download_data,
+                           const QString& error)> download_complete,
         std::function<void(CefRefPtr<CefURLRequest> request,
                            uint64 current,
                            uint64 total)> download_progress);
@@ -91,16 +88,16 @@ class Cef {
     }
 
    private:
-    QIODevice* write_to_;
-    std::function<void(CefRefPtr<CefURLRequest> request,
-                       QIODevice* device)> download_complete_;
+    std::unique_ptr<DownloadSink> sink_;
+    // Set once the sink fails, the rest of the data is ignored
+    QString sink_error_;
     std::function<void(CefRefPtr<CefURLRequest> request,
-                       QIODevice* device)> download_data_;
+                       const QString& error)> download_complete_;
     std::function<void(CefRefPtr<CefURLRequest> request,
                        uint64 current,
                        uint64 total)> download_progress_;
 
-    IMPLEMENT_REFCOUNTING(CallbackFullDownload);
+    IMPLEMENT_REFCOUNTING(SinkDownload);
   };
 
   cef_main_args_t MainArgs(int argc, char* argv[]);
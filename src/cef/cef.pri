@@ -4,7 +4,8 @@ SOURCES += \
     cef/cef_app_handler.cc \
     cef/cef_base_widget.cc \
     cef/cef_handler.cc \
-    cef/cef_widget.cc
+    cef/cef_widget.cc \
+    cef/favicon_cache.cc
 
 HEADERS += \
     cef/cef.h \
@@ -13,6 +14,7 @@ HEADERS += \
     cef/cef_base_widget.h \
     cef/cef_handler.h \
     cef/cef_widget.h \
+    cef/favicon_cache.h \
 
 INCLUDEPATH += $$(CEF_DIR)
 
@@ -4,7 +4,12 @@
 
 namespace doogie {
 
-CefAppHandler::CefAppHandler() {}
+CefAppHandler::CefAppHandler() {
+  // Always queued so CEF threads never touch the timer
+  connect(this, &CefAppHandler::MessagePumpWorkScheduled,
+          this, &CefAppHandler::SchedulePumpWork,
+          Qt::QueuedConnection);
+}
 
 void CefAppHandler::OnContextCreated(CefRefPtr<CefBrowser> browser,
                                      CefRefPtr<CefFrame> frame,
@@ -27,4 +32,56 @@ void CefAppHandler::OnContextCreated(CefRefPtr<CefBrowser> browser,
 void CefAppHandler::OnWebKitInitialized() {
 }
 
+void CefAppHandler::OnScheduleMessagePumpWork(int64 delay_ms) {
+  emit MessagePumpWorkScheduled(delay_ms);
+}
+
+void CefAppHandler::StopMessagePump() {
+  pump_stopped_ = true;
+  if (pump_timer_) pump_timer_->stop();
+}
+
+void CefAppHandler::SchedulePumpWork(qint64 delay_ms) {
+  if (pump_stopped_) return;
+  if (!pump_timer_) {
+    pump_timer_ = new QTimer(this);
+    pump_timer_->setSingleShot(true);
+    pump_timer_->setTimerType(Qt::PreciseTimer);
+    connect(pump_timer_, &QTimer::timeout, this, &CefAppHandler::DoPumpWork);
+  }
+  // CEF is asking, so we're not idle anymore
+  idle_pump_delay_ms_ = kMinIdlePumpDelayMs;
+  if (delay_ms <= 0) {
+    pump_timer_->stop();
+    DoPumpWork();
+    return;
+  }
+  // Only ever move the work sooner
+  auto delay = static_cast<int>(qMin<qint64>(delay_ms, kMaxIdlePumpDelayMs));
+  if (pump_timer_->isActive() && pump_timer_->remainingTime() <= delay) {
+    return;
+  }
+  pump_timer_->start(delay);
+}
+
+void CefAppHandler::DoPumpWork() {
+  if (pump_stopped_) return;
+  // Nested event loops (e.g. dialogs) can land us back in here while CEF
+  //  is still working, so we just run again once it's done
+  if (pump_active_) {
+    pump_reentered_ = true;
+    return;
+  }
+  pump_active_ = true;
+  CefDoMessageLoopWork();
+  pump_active_ = false;
+  if (pump_reentered_) {
+    pump_reentered_ = false;
+    pump_timer_->start(0);
+  } else if (!pump_timer_->isActive()) {
+    pump_timer_->start(idle_pump_delay_ms_);
+    idle_pump_delay_ms_ = qMin(idle_pump_delay_ms_ * 2, kMaxIdlePumpDelayMs);
+  }
+}
+
 }  // namespace doogie
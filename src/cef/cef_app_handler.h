@@ -34,8 +34,32 @@ class CefAppHandler :
 
   void OnWebKitInitialized() override;
 
+  // Browser process handler overrides...
+  // Can be called from any thread
+  void OnScheduleMessagePumpWork(int64 delay_ms) override;
+
+  // Must be called before CEF is shut down, no more work is done after
+  void StopMessagePump();
+
+ signals:
+  void MessagePumpWorkScheduled(qint64 delay_ms);
+
  private:
+  // When CEF hasn't asked for work, we still do some every so often in
+  //  case it missed telling us. This starts at the min and backs off to
+  //  the max the longer we're idle.
+  static const int kMinIdlePumpDelayMs = 1000 / 30;
+  static const int kMaxIdlePumpDelayMs = 1000;
+
+  void SchedulePumpWork(qint64 delay_ms);
+  void DoPumpWork();
+
   CosmeticBlocker blocker_;
+  QTimer* pump_timer_ = nullptr;
+  bool pump_stopped_ = false;
+  bool pump_active_ = false;
+  bool pump_reentered_ = false;
+  int idle_pump_delay_ms_ = kMinIdlePumpDelayMs;
 
   IMPLEMENT_REFCOUNTING(CefAppHandler);
 };
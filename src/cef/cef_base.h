@@ -17,6 +17,7 @@
 #include "include/cef_file_util.h"
 #include "include/cef_parser.h"
 #include "include/cef_request_context_handler.h"
+#include "include/cef_trace.h"
 #include "include/cef_urlrequest.h"
 #include "include/cef_xml_reader.h"
 #include "include/cef_zip_reader.h"
@@ -2,6 +2,8 @@
 
 #include <string>
 
+#include "cef/favicon_cache.h"
+
 namespace doogie {
 
 CefWidget::CefWidget(const Cef& cef,
@@ -30,13 +32,13 @@ CefWidget::CefWidget(const Cef& cef,
     static const auto favicon_sig =
         QMetaMethod::fromSignal(&CefWidget::FaviconChanged);
     if (this->isSignalConnected(favicon_sig) && browser_) {
-      // Download the favicon
-      browser_->GetHost()->DownloadImage(
-            CefString(url.toStdString()),
-            true,
-            16,
-            false,
-            new CefWidget::FaviconDownloadCallback(this));
+      // Shared w/ all other pages, so this may not even download
+      favicon_url_ = url;
+      FaviconCache::Fetch(browser_->GetHost(), url, this,
+                          [=](const QIcon& icon) {
+        // Ignore it if the page has moved on to another one since
+        if (favicon_url_ == url) emit FaviconChanged(url, icon);
+      });
     }
   });
   connect(handler_, &CefHandler::FullscreenModeChange, [=](bool fullscreen) {
@@ -81,6 +83,7 @@ CefWidget::~CefWidget() {
   if (browser_) {
     browser_->GetHost()->CloseBrowser(true);
   }
+  Bubble::ReleaseCefRequestContext(bubble_id_, request_context_);
 }
 
 std::vector<CefWidget::NavEntry> CefWidget::NavEntries() const {
@@ -305,33 +308,6 @@ void CefWidget::UpdateSize() {
   if (browser_) browser_->GetHost()->NotifyMoveOrResizeStarted();
 }
 
-void CefWidget::FaviconDownloadCallback::OnDownloadImageFinished(
-    const CefString& url, int, CefRefPtr<CefImage> image) {
-  // TODO(cretz): should I somehow check if the page has changed before
-  //  this came back?
-  QIcon icon;
-  if (image) {
-    // TODO(cretz): This would be quicker if we used GetAsBitmap
-    int width, height;
-    auto png = image->GetAsPNG(1.0f, true, width, height);
-    if (!png) {
-      qDebug("Unable to get icon as PNG");
-    } else {
-      auto size = png->GetSize();
-      std::vector<uchar> data(size);
-      png->GetData(&data[0], size, 0);
-      QPixmap pixmap;
-      if (!pixmap.loadFromData(&data[0], (uint)size, "PNG")) {
-        qDebug("Unable to convert icon as PNG");
-      } else {
-        icon.addPixmap(pixmap);
-      }
-    }
-  }
-  emit cef_widg_->FaviconChanged(QString::fromStdString(url.ToString()),
-                                 icon);
-}
-
 bool CefWidget::NavEntryVisitor::Visit(CefRefPtr<CefNavigationEntry> entry,
                                        bool current,
                                        int, int) {
@@ -355,13 +331,15 @@ bool CefWidget::NavEntryCurrentSslVisitor::Visit(
 void CefWidget::InitBrowser(const Bubble& bubble, const QString& url) {
   CefBrowserSettings settings;
   bubble.ApplyCefBrowserSettings(&settings);
+  bubble_id_ = bubble.Id();
+  request_context_ = bubble.AcquireCefRequestContext();
   browser_ = CefBrowserHost::CreateBrowserSync(
         window_info_,
         handler_,
         CefString(url.toStdString()),
         settings,
         CefDictionaryValue::Create(),
-        bubble.CreateCefRequestContext());
+        request_context_);
 }
 
 void CefWidget::AuthRequest(const QString& realm,
@@ -111,19 +111,6 @@ class CefWidget : public CefBaseWidget {
   void UpdateSize() override;
 
  private:
-  class FaviconDownloadCallback : public CefDownloadImageCallback {
-   public:
-    explicit FaviconDownloadCallback(QPointer<CefWidget> cef_widg)
-      : cef_widg_(cef_widg) {}
-    void OnDownloadImageFinished(const CefString& image_url,
-                                 int http_status_code,
-                                 CefRefPtr<CefImage> image) override;
-   private:
-    QPointer<CefWidget> cef_widg_;
-    IMPLEMENT_REFCOUNTING(FaviconDownloadCallback);
-    DISALLOW_COPY_AND_ASSIGN(FaviconDownloadCallback);
-  };
-
   class NavEntryVisitor : public CefNavigationEntryVisitor {
    public:
     bool Visit(CefRefPtr<CefNavigationEntry> entry,
@@ -153,9 +140,11 @@ class CefWidget : public CefBaseWidget {
 
   CefRefPtr<CefHandler> handler_;
   CefRefPtr<CefBrowser> browser_;
+  qlonglong bubble_id_ = -1;
+  CefRefPtr<CefRequestContext> request_context_;
   CefRefPtr<CefHandler> dev_tools_handler_;
   CefRefPtr<CefBrowser> dev_tools_browser_;
-  bool download_favicon_ = false;
+  QString favicon_url_;
   bool js_triggered_fullscreen_ = false;
 };
 
@@ -0,0 +1,132 @@
+#include "cef/favicon_cache.h"
+
+#include "util.h"
+
+namespace doogie {
+
+QCache<QString, FaviconCache::CachedIcon>* FaviconCache::icons_ = nullptr;
+QHash<QString, QList<FaviconCache::Waiter>> FaviconCache::waiters_;
+
+void FaviconCache::Fetch(CefRefPtr<CefBrowserHost> host,
+                         const QString& url,
+                         QObject* receiver,
+                         std::function<void(const QIcon&)> callback) {
+  if (icons_) {
+    auto cached = icons_->object(url);
+    if (cached && QDateTime::currentMSecsSinceEpoch() -
+        cached->fetched_ms < kMaxAgeMs) {
+      callback(cached->icon);
+      return;
+    }
+    // Too old, whatever is downloaded replaces it
+    if (cached) icons_->remove(url);
+  }
+  auto in_flight = waiters_.contains(url);
+  Waiter waiter { receiver, callback, host };
+  waiters_[url].append(waiter);
+  if (!in_flight) Download(host, url);
+}
+
+FaviconCache::DownloadCallback::~DownloadCallback() {
+  // Dropped w/out being called (e.g. browser closed), don't leave the
+  // waiters hanging or the URL would never be fetched again
+  if (!finished_) {
+    auto url = url_;
+    auto host = host_;
+    Util::RunOnMainThread([=]() { Redownload(url, host); });
+  }
+}
+
+void FaviconCache::DownloadCallback::OnDownloadImageFinished(
+    const CefString&, int, CefRefPtr<CefImage> image) {
+  // We pump CEF ourselves, so this is the GUI thread
+  finished_ = true;
+  if (!image || image->IsEmpty()) {
+    Finish(url_, QIcon());
+    return;
+  }
+  // Raw bitmap instead of round tripping through PNG. BGRA premultiplied
+  // is what QImage::Format_ARGB32_Premultiplied is in memory on the
+  // little-endian platforms we run on.
+  int width = 0, height = 0;
+  auto bitmap = image->GetAsBitmap(1.0f,
+                                   CEF_COLOR_TYPE_BGRA_8888,
+                                   CEF_ALPHA_TYPE_PREMULTIPLIED,
+                                   width,
+                                   height);
+  auto size = bitmap ? bitmap->GetSize() : 0;
+  if (size == 0 || size < static_cast<size_t>(width * height * 4)) {
+    qDebug() << "Unable to get favicon bitmap for" << url_;
+    Finish(url_, QIcon());
+    return;
+  }
+  QByteArray bgra(static_cast<int>(size), Qt::Uninitialized);
+  bitmap->GetData(bgra.data(), size, 0);
+  QThreadPool::globalInstance()->start(
+        new DecodeTask(url_, bgra, width, height));
+}
+
+void FaviconCache::DecodeTask::run() {
+  QImage image(reinterpret_cast<const uchar*>(bgra_.constData()),
+               width_, height_, width_ * 4,
+               QImage::Format_ARGB32_Premultiplied);
+  // Detach from our buffer, it goes away w/ this task
+  if (width_ > kIconSize || height_ > kIconSize) {
+    image = image.scaled(kIconSize, kIconSize,
+                         Qt::KeepAspectRatio, Qt::SmoothTransformation);
+  } else {
+    image = image.copy();
+  }
+  auto url = url_;
+  Util::RunOnMainThread([=]() {
+    // Pixmaps can only be made on the GUI thread
+    auto pixmap = QPixmap::fromImage(image);
+    Finish(url, pixmap.isNull() ? QIcon() : QIcon(pixmap));
+  });
+}
+
+void FaviconCache::Download(CefRefPtr<CefBrowserHost> host,
+                            const QString& url) {
+  host->DownloadImage(CefString(url.toStdString()),
+                      true,
+                      kIconSize,
+                      false,
+                      new DownloadCallback(url, host.get()));
+}
+
+void FaviconCache::Redownload(const QString& url,
+                              CefBrowserHost* dropped_by) {
+  // The ones that asked through the dropping host get nothing, the rest
+  // try again through the first of their hosts. Each time at least one
+  // host is given up on, so this ends.
+  QList<Waiter> remaining;
+  for (const auto& waiter : waiters_.take(url)) {
+    if (!waiter.receiver) continue;
+    if (waiter.host.get() == dropped_by) {
+      waiter.callback(QIcon());
+    } else {
+      remaining.append(waiter);
+    }
+  }
+  if (remaining.isEmpty()) return;
+  // A callback above may have already fetched it again
+  auto in_flight = waiters_.contains(url);
+  waiters_[url].append(remaining);
+  if (!in_flight) Download(remaining.first().host, url);
+}
+
+void FaviconCache::Finish(const QString& url, const QIcon& icon) {
+  if (!icon.isNull()) {
+    if (!icons_) icons_ = new QCache<QString, CachedIcon>(kMaxIcons);
+    icons_->insert(url, new CachedIcon {
+      icon, QDateTime::currentMSecsSinceEpoch()
+    });
+  }
+  for (const auto& waiter : waiters_.take(url)) {
+    if (waiter.receiver) waiter.callback(icon);
+  }
+}
+
+FaviconCache::FaviconCache() { }
+
+}  // namespace doogie
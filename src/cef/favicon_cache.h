@@ -0,0 +1,95 @@
+#ifndef DOOGIE_FAVICON_CACHE_H_
+#define DOOGIE_FAVICON_CACHE_H_
+
+#include <QtWidgets>
+#include <functional>
+
+#include "cef/cef_base.h"
+
+namespace doogie {
+
+// Downloaded favicons keyed by favicon URL and shared by every browser, so
+// any number of pages on the same site cause a single download and decode.
+// Decoding from the raw bitmap happens off the GUI thread. Failures are not
+// cached and successes only for a while, since sites do change them. Must
+// be used on the GUI thread.
+class FaviconCache {
+ public:
+  // Max decoded icons to keep in memory
+  static const int kMaxIcons = 500;
+  // Bigger bitmaps are scaled down to this
+  static const int kIconSize = 16;
+  // Cached icons older than this are downloaded again when next asked for
+  static const qint64 kMaxAgeMs = 60 * 60 * 1000;
+
+  // The callback gets a null icon on failure. It is called immediately if
+  //  cached, otherwise once the download the given host starts (or one
+  //  already in flight for the same URL) is done. If the browser doing the
+  //  download closes first, another waiter's host downloads it instead.
+  //  Not called if the receiver is gone by then.
+  static void Fetch(CefRefPtr<CefBrowserHost> host,
+                    const QString& url,
+                    QObject* receiver,
+                    std::function<void(const QIcon&)> callback);
+
+ private:
+  class DownloadCallback : public CefDownloadImageCallback {
+   public:
+    DownloadCallback(const QString& url, CefBrowserHost* host)
+      : url_(url), host_(host) {}
+    ~DownloadCallback();
+    void OnDownloadImageFinished(const CefString& image_url,
+                                 int http_status_code,
+                                 CefRefPtr<CefImage> image) override;
+   private:
+    QString url_;
+    // Only to know whose waiters to give up on, never called
+    CefBrowserHost* host_;
+    bool finished_ = false;
+    IMPLEMENT_REFCOUNTING(DownloadCallback);
+    DISALLOW_COPY_AND_ASSIGN(DownloadCallback);
+  };
+
+  class DecodeTask : public QRunnable {
+   public:
+    DecodeTask(const QString& url,
+               const QByteArray& bgra,
+               int width,
+               int height)
+      : url_(url), bgra_(bgra), width_(width), height_(height) {}
+    void run() override;
+   private:
+    QString url_;
+    QByteArray bgra_;
+    int width_;
+    int height_;
+  };
+
+  struct Waiter {
+    QPointer<QObject> receiver;
+    std::function<void(const QIcon&)> callback;
+    // What it asked through, kept alive in case we have to download again
+    CefRefPtr<CefBrowserHost> host;
+  };
+
+  struct CachedIcon {
+    QIcon icon;
+    qint64 fetched_ms;
+  };
+
+  static void Download(CefRefPtr<CefBrowserHost> host, const QString& url);
+  // The download was dropped by the host w/out finishing
+  static void Redownload(const QString& url, CefBrowserHost* dropped_by);
+  static void Finish(const QString& url, const QIcon& icon);
+
+  // Created lazily and never freed since pixmaps can't outlive the app
+  static QCache<QString, CachedIcon>* icons_;
+  // Keyed by URL, only present while a download or decode is in flight
+  static QHash<QString, QList<Waiter>> waiters_;
+
+  FaviconCache();
+};
+
+}  // namespace doogie
+
+#endif  // DOOGIE_FAVICON_CACHE_H_
@@ -1,5 +1,5 @@
 
-QT += core gui widgets sql
+QT += core gui widgets sql network
 TARGET = doogie
 TEMPLATE = app
 DEFINES += QT_DEPRECATED_WARNINGS
@@ -25,21 +25,36 @@ SOURCES += \
     download.cc \
     downloads_dock.cc \
     download_list_item.cc \
+    download_sink.cc \
+    favicon_store.cc \
     find_widget.cc \
+    frecency_index.cc \
+    log_file_sink.cc \
+    log_store.cc \
     logging_dock.cc \
     main.cc \
+    main_thread_queue.cc \
     main_window.cc \
-    page_close_button.cc \
+    metrics_registry.cc \
+    metrics_server.cc \
     page_index.cc \
+    page_load_scheduler.cc \
     page_tree.cc \
+    page_tree_delegate.cc \
     page_tree_dock.cc \
     page_tree_item.cc \
     profile.cc \
     profile_change_dialog.cc \
     profile_settings_dialog.cc \
+    screenshot_cache.cc \
     settings_widget.cc \
     sql.cc \
+    sql_executor.cc \
     ssl_info_action.cc \
+    startup_profile.cc \
+    suspended_page_view.cc \
+    suspension_policy.cc \
+    tracing.cc \
     updater.cc \
     url_edit.cc \
     util.cc \
@@ -62,20 +77,35 @@ HEADERS += \
     download.h \
     downloads_dock.h \
     download_list_item.h \
+    download_sink.h \
+    favicon_store.h \
     find_widget.h \
+    frecency_index.h \
+    log_file_sink.h \
+    log_store.h \
     logging_dock.h \
+    main_thread_queue.h \
     main_window.h \
-    page_close_button.h \
+    metrics_registry.h \
+    metrics_server.h \
     page_index.h \
+    page_load_scheduler.h \
     page_tree.h \
+    page_tree_delegate.h \
     page_tree_dock.h \
     page_tree_item.h \
     profile.h \
     profile_change_dialog.h \
     profile_settings_dialog.h \
+    screenshot_cache.h \
     settings_widget.h \
     sql.h \
+    sql_executor.h \
     ssl_info_action.h \
+    startup_profile.h \
+    suspended_page_view.h \
+    suspension_policy.h \
+    tracing.h \
     updater.h \
     url_edit.h \
     util.h \
@@ -95,7 +125,7 @@ release:PROFILE = Release
 debug:PROFILE = Debug
 
 win32 {
-    LIBS += -luser32 -lcrypt32 -lcryptui
+    LIBS += -luser32 -lcrypt32 -lcryptui -lpsapi
 
     SOURCES += \
         util_win.cc
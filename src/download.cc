@@ -6,6 +6,7 @@ namespace doogie {
 
 QList<Download> Download::Downloads() {
   QList<Download> ret;
+  SqlExecutor::WaitFor("download");
   QSqlQuery query;
   if (!Sql::Exec(&query, "SELECT * FROM download ORDER BY start_time")) {
     return ret;
@@ -24,6 +25,7 @@ bool Download::ClearDownloads(QList<qlonglong> exclude_ids) {
     }
     sql += ")";
   }
+  SqlExecutor::WaitFor("download");
   QSqlQuery query;
   return Sql::Exec(&query, sql);
 }
@@ -56,36 +58,78 @@ void Download::Resume() {
 }
 
 bool Download::Persist() {
-  QSqlQuery query;
   if (Exists()) {
     if (end_time_.isNull()) return true;
-    return Sql::ExecParam(
-          &query,
-          "UPDATE download SET end_time = ?, success = ? "
-          "WHERE id = ?",
-          { end_time_.toSecsSinceEpoch(),
-            current_state_ == Complete, db_id_ });
+    QVariantList params = { end_time_.toSecsSinceEpoch(),
+                            current_state_ == Complete };
+    auto key = DbKey();
+    SqlExecutor::Enqueue([=](QSqlQuery* query) -> QVariant {
+      auto id = SqlExecutor::ResolveKey(key);
+      if (id < 0 || !Sql::ExecParam(query,
+                                    "UPDATE download SET "
+                                    "  end_time = ?, success = ? "
+                                    "WHERE id = ?",
+                                    params + QVariantList { id })) {
+        return QVariant();
+      }
+      return true;
+    }, { "download" });
+    return true;
   }
-  auto ok = Sql::ExecParam(
-        &query,
-        "INSERT INTO download ( "
-        "  mime_type, orig_url, url, path, "
-        "  success, start_time, size "
-        ") VALUES (?, ?, ?, ?, ?, ?, ?)",
-        { mime_type_, orig_url_, url_, path_,
-          current_state_ == Complete,
-          start_time_.toSecsSinceEpoch(), total_bytes_ });
-  if (!ok) return false;
-  db_id_ = query.lastInsertId().toLongLong();
+  QVariantList params = { mime_type_, orig_url_, url_, path_,
+                          current_state_ == Complete,
+                          start_time_.toSecsSinceEpoch(), total_bytes_ };
+  auto key = SqlExecutor::NewKey();
+  pending_db_id_ = SqlExecutor::Enqueue([=](QSqlQuery* query) -> QVariant {
+    auto ok = Sql::ExecParam(
+          query,
+          "INSERT INTO download ( "
+          "  mime_type, orig_url, url, path, "
+          "  success, start_time, size "
+          ") VALUES (?, ?, ?, ?, ?, ?, ?)",
+          params);
+    auto id = ok ? query->lastInsertId().toLongLong() : -1;
+    SqlExecutor::MapKey(key, id);
+    if (!ok) return QVariant();
+    return id;
+  }, { "download" });
+  db_key_ = key;
   return true;
 }
 
 bool Download::Delete() {
   if (!Exists()) return false;
-  QSqlQuery query;
-  return Sql::ExecParam(&query,
-                        "DELETE FROM download WHERE id = ?",
-                        { db_id_ });
+  auto key = DbKey();
+  SqlExecutor::Enqueue([=](QSqlQuery* query) -> QVariant {
+    auto id = SqlExecutor::ResolveKey(key);
+    if (id < 0 ||
+        !Sql::ExecParam(query, "DELETE FROM download WHERE id = ?", { id })) {
+      return QVariant();
+    }
+    return true;
+  }, { "download" });
+  return true;
+}
+
+qlonglong Download::DbKey() const {
+  if (db_key_ < -1 && pending_db_id_.valid() &&
+      pending_db_id_.wait_for(std::chrono::seconds(0)) ==
+          std::future_status::ready) {
+    // Our writes are all queued right away, so none are still to come
+    SqlExecutor::ForgetKey(db_key_);
+    db_key_ = -1;
+    DbId();
+  }
+  return db_key_ < -1 ? db_key_ : db_id_;
+}
+
+qlonglong Download::DbId() const {
+  if (pending_db_id_.valid()) {
+    auto id = pending_db_id_.get();
+    db_id_ = id.isValid() ? id.toLongLong() : -1;
+    pending_db_id_ = SqlExecutor::Result();
+  }
+  return db_id_;
 }
 
 Download::Download(const QSqlRecord& record) {
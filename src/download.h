@@ -5,6 +5,7 @@
 #include <QtWidgets>
 
 #include "cef/cef.h"
+#include "sql_executor.h"
 
 namespace doogie {
 
@@ -40,9 +41,15 @@ class Download {
   bool Persist();
   bool Delete();
 
-  qlonglong DbId() const { return db_id_; }
-  void SetDbId(qlonglong db_id) { db_id_ = db_id; }
-  bool Exists() const { return db_id_ > -1; }
+  // Note, this waits on the writer if the insert is still queued
+  qlonglong DbId() const;
+  // Makes this the same row as the other, w/out waiting on its insert
+  void SetDbIdFrom(const Download& other) {
+    db_id_ = other.db_id_;
+    pending_db_id_ = other.pending_db_id_;
+    db_key_ = other.db_key_;
+  }
+  bool Exists() const { return db_id_ > -1 || db_key_ < -1; }
 
   uint LiveId() const { return live_id_; }
   QString MimeType() const { return mime_type_; }
@@ -62,8 +69,16 @@ class Download {
   explicit Download(const QSqlRecord& record);
 
   void FromCef(CefRefPtr<CefDownloadItem> item);
-
-  qlonglong db_id_ = -1;
+  // Never waits. Once the insert is done, this gives the ID and the key is
+  //  let go.
+  qlonglong DbKey() const;
+
+  // Mutable because they are resolved lazily once the insert is done
+  mutable qlonglong db_id_ = -1;
+  mutable SqlExecutor::Result pending_db_id_;
+  // Less than -1 if inserted this run and the ID isn't known yet, see
+  //  SqlExecutor::NewKey
+  mutable qlonglong db_key_ = -1;
   uint live_id_ = -1;
   QString mime_type_;
   QString orig_url_;
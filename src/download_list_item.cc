@@ -84,11 +84,10 @@ bool DownloadListItem::UpdateDownload(const Download& d) {
   // We only update live, and it has to be the right live ID
   if (download_.Exists() && download_.LiveId() != d.LiveId()) return false;
 
-  // Set it and persist it
-  auto old_id = -1;
-  if (download_.Exists()) old_id = download_.DbId();
+  // Set it and persist it, keeping the row we already have
+  auto old = download_;
   download_ = d;
-  if (old_id >= 0) download_.SetDbId(old_id);
+  if (old.Exists()) download_.SetDbIdFrom(old);
   download_.Persist();
 
   // Update the widgets
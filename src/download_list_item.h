@@ -17,6 +17,7 @@ class DownloadListItem : public QListWidgetItem {
   void ApplyContextMenu(QMenu* menu);
   void DeleteAndRemoveIfDone();
   bool DownloadActive();
+  const Download& CurrentDownload() const { return download_; }
  private:
   Download download_;
 
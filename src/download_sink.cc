@@ -0,0 +1,301 @@
+#include "download_sink.h"
+
+#include <zlib.h>
+#include <cstring>
+
+namespace doogie {
+
+DownloadSink::~DownloadSink() { }
+
+bool DownloadSink::Write(const char* data, qint64 len) {
+  return WriteNext(data, len);
+}
+
+bool DownloadSink::Finish() {
+  if (next_ && !next_->Finish()) return Fail(next_->ErrorString());
+  return true;
+}
+
+void DownloadSink::Abort() {
+  if (next_) next_->Abort();
+}
+
+DownloadSink::DownloadSink(DownloadSink* next) : next_(next) { }
+
+bool DownloadSink::Fail(const QString& error) {
+  if (error_.isEmpty()) error_ = error;
+  return false;
+}
+
+bool DownloadSink::WriteNext(const char* data, qint64 len) {
+  if (next_ && len > 0 && !next_->Write(data, len)) {
+    return Fail(next_->ErrorString());
+  }
+  return true;
+}
+
+FileDownloadSink::FileDownloadSink(const QString& path) : file_(path) {
+  QDir().mkpath(QFileInfo(path).path());
+  // Failure is reported on first write
+  file_.open(QIODevice::WriteOnly);
+}
+
+bool FileDownloadSink::Write(const char* data, qint64 len) {
+  if (!file_.isOpen() || file_.write(data, len) != len) {
+    return Fail(QString("Unable to write to %1: %2").
+                arg(file_.fileName(), file_.errorString()));
+  }
+  return true;
+}
+
+bool FileDownloadSink::Finish() {
+  if (!file_.isOpen() || !file_.commit()) {
+    return Fail(QString("Unable to save %1: %2").
+                arg(file_.fileName(), file_.errorString()));
+  }
+  return true;
+}
+
+void FileDownloadSink::Abort() {
+  // Removes the temp file, the real one is untouched
+  if (file_.isOpen()) file_.cancelWriting();
+}
+
+BufferDownloadSink::BufferDownloadSink(qint64 max_size)
+    : max_size_(max_size) { }
+
+bool BufferDownloadSink::Write(const char* data, qint64 len) {
+  if (data_.size() + len > max_size_) {
+    return Fail(QString("Response larger than %1 bytes").arg(max_size_));
+  }
+  data_.append(data, static_cast<int>(len));
+  return true;
+}
+
+ChecksumDownloadSink::ChecksumDownloadSink(
+    QCryptographicHash::Algorithm algorithm, DownloadSink* next)
+    : DownloadSink(next), hash_(algorithm) { }
+
+bool ChecksumDownloadSink::Write(const char* data, qint64 len) {
+  hash_.addData(data, static_cast<int>(len));
+  return WriteNext(data, len);
+}
+
+LineDownloadSink::LineDownloadSink(
+    std::function<bool(const QString&)> callback, DownloadSink* next)
+    : DownloadSink(next), callback_(callback) { }
+
+bool LineDownloadSink::Write(const char* data, qint64 len) {
+  auto start = data;
+  auto end = data + len;
+  while (start < end) {
+    auto newline = static_cast<const char*>(
+          std::memchr(start, '\n', end - start));
+    if (!newline) break;
+    auto line_len = static_cast<int>(newline - start);
+    if (partial_.isEmpty()) {
+      if (!EmitLine(start, line_len)) return false;
+    } else {
+      partial_.append(start, line_len);
+      if (!EmitLine(partial_.constData(), partial_.size())) return false;
+      partial_.clear();
+    }
+    start = newline + 1;
+  }
+  partial_.append(start, static_cast<int>(end - start));
+  return WriteNext(data, len);
+}
+
+bool LineDownloadSink::Finish() {
+  if (!partial_.isEmpty()) {
+    if (!EmitLine(partial_.constData(), partial_.size())) return false;
+    partial_.clear();
+  }
+  return DownloadSink::Finish();
+}
+
+bool LineDownloadSink::EmitLine(const char* data, int len) {
+  if (len > 0 && data[len - 1] == '\r') len--;
+  if (!callback_(QString::fromUtf8(data, len))) {
+    return Fail("Line rejected");
+  }
+  return true;
+}
+
+struct InflateDownloadSink::Stream {
+  z_stream z;
+  bool initialized;
+};
+
+InflateDownloadSink::InflateDownloadSink(Format format, DownloadSink* next)
+    : DownloadSink(next), stream_(new Stream) {
+  std::memset(&stream_->z, 0, sizeof(stream_->z));
+  // 32 more lets zlib figure out gzip vs zlib on its own
+  auto window_bits = format == RawDeflate ? -MAX_WBITS : MAX_WBITS + 32;
+  stream_->initialized = inflateInit2(&stream_->z, window_bits) == Z_OK;
+}
+
+InflateDownloadSink::~InflateDownloadSink() {
+  if (stream_->initialized) inflateEnd(&stream_->z);
+}
+
+bool InflateDownloadSink::Write(const char* data, qint64 len) {
+  if (!stream_->initialized) return Fail("Unable to start inflating");
+  if (ended_) return true;
+  char out[16 * 1024];
+  auto& z = stream_->z;
+  z.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+  z.avail_in = static_cast<uInt>(len);
+  do {
+    z.next_out = reinterpret_cast<Bytef*>(out);
+    z.avail_out = sizeof(out);
+    auto result = inflate(&z, Z_NO_FLUSH);
+    if (result != Z_OK && result != Z_STREAM_END && result != Z_BUF_ERROR) {
+      return Fail(QString("Unable to inflate: %1").
+                  arg(z.msg ? z.msg : "unknown error"));
+    }
+    if (!WriteNext(out, sizeof(out) - z.avail_out)) return false;
+    if (result == Z_STREAM_END) {
+      ended_ = true;
+      break;
+    }
+  } while (z.avail_in > 0 || z.avail_out == 0);
+  return true;
+}
+
+bool InflateDownloadSink::Finish() {
+  if (!ended_) return Fail("Compressed data ended early");
+  return DownloadSink::Finish();
+}
+
+ZipEntryDownloadSink::ZipEntryDownloadSink(const QString& entry_name,
+                                           DownloadSink* next)
+    : DownloadSink(next), entry_name_(entry_name) { }
+
+bool ZipEntryDownloadSink::Write(const char* data, qint64 len) {
+  // Everything is little endian
+  auto u16 = [this](int at) -> quint16 {
+    return qFromLittleEndian<quint16>(buffer_.constData() + at);
+  };
+  auto u32 = [this](int at) -> quint32 {
+    return qFromLittleEndian<quint32>(buffer_.constData() + at);
+  };
+  while (len > 0) {
+    switch (state_) {
+      case CrxMagic: {
+        if (!Buffer(&data, &len, 12)) return true;
+        if (!buffer_.startsWith("Cr24")) {
+          // Plain zip, what we have is the start of the first header
+          state_ = LocalHeader;
+          break;
+        }
+        auto version = u32(4);
+        if (version == 3) {
+          wanted_ = u32(8);
+        } else if (version == 2) {
+          // Public key and signature lengths
+          if (!Buffer(&data, &len, 16)) return true;
+          wanted_ = static_cast<qint64>(u32(8)) + u32(12);
+        } else {
+          return Fail(QString("Unknown CRX version %1").arg(version));
+        }
+        buffer_.clear();
+        state_ = CrxHeader;
+        break;
+      }
+      case CrxHeader:
+      case SkipEntry: {
+        auto skip = qMin(len, wanted_);
+        data += skip;
+        len -= skip;
+        wanted_ -= skip;
+        if (wanted_ == 0) state_ = LocalHeader;
+        break;
+      }
+      case LocalHeader:
+        if (!Buffer(&data, &len, kLocalHeaderSize)) return true;
+        if (u32(0) != 0x04034b50) {
+          // Central directory or garbage, either way no more entries
+          state_ = Done;
+          break;
+        }
+        flags_ = u16(6);
+        method_ = u16(8);
+        compressed_size_ = u32(18);
+        name_len_ = u16(26);
+        wanted_ = kLocalHeaderSize + name_len_ + u16(28);
+        state_ = LocalHeaderNameAndExtra;
+        break;
+      case LocalHeaderNameAndExtra:
+        if (!Buffer(&data, &len, static_cast<int>(wanted_))) return true;
+        if (!StartEntry()) return false;
+        break;
+      case Entry: {
+        // Negative means unknown size, inflate stops on its own
+        auto write = wanted_ < 0 ? len : qMin(len, wanted_);
+        if (!WriteNext(data, write)) return false;
+        data += write;
+        len -= write;
+        if (wanted_ > 0) wanted_ -= write;
+        if (wanted_ == 0) state_ = Done;
+        break;
+      }
+      case Done:
+        return true;
+    }
+  }
+  return true;
+}
+
+bool ZipEntryDownloadSink::Finish() {
+  if (!found_) {
+    return Fail(QString("Zip entry %1 not found").arg(entry_name_));
+  }
+  if (state_ == Entry && wanted_ > 0) {
+    return Fail(QString("Zip entry %1 truncated").arg(entry_name_));
+  }
+  return DownloadSink::Finish();
+}
+
+bool ZipEntryDownloadSink::Buffer(const char** data, qint64* len, int size) {
+  auto needed = qMin(static_cast<qint64>(size - buffer_.size()), *len);
+  if (needed > 0) {
+    buffer_.append(*data, static_cast<int>(needed));
+    *data += needed;
+    *len -= needed;
+  }
+  return buffer_.size() >= size;
+}
+
+bool ZipEntryDownloadSink::StartEntry() {
+  auto name = QString::fromUtf8(buffer_.constData() + kLocalHeaderSize,
+                                name_len_);
+  buffer_.clear();
+  // Bit 0 is encryption, bit 3 means sizes are only known after the data
+  if (flags_ & 0x1) return Fail(QString("Zip entry %1 encrypted").arg(name));
+  auto unknown_size = (flags_ & 0x8) != 0;
+  if (compressed_size_ == 0xFFFFFFFF) {
+    return Fail(QString("Zip64 entry %1 not supported").arg(name));
+  }
+  if (name != entry_name_) {
+    if (unknown_size) {
+      return Fail(QString("Zip entry %1 has unknown size").arg(name));
+    }
+    wanted_ = compressed_size_;
+    state_ = wanted_ == 0 ? LocalHeader : SkipEntry;
+    return true;
+  }
+  found_ = true;
+  if (method_ == 8) {
+    next_.reset(new InflateDownloadSink(InflateDownloadSink::RawDeflate,
+                                        next_.release()));
+  } else if (method_ != 0 || unknown_size) {
+    return Fail(QString("Zip entry %1 has unsupported compression").
+                arg(name));
+  }
+  wanted_ = unknown_size ? -1 : compressed_size_;
+  state_ = wanted_ == 0 ? Done : Entry;
+  return true;
+}
+
+}  // namespace doogie
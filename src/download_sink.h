@@ -0,0 +1,173 @@
+#ifndef DOOGIE_DOWNLOAD_SINK_H_
+#define DOOGIE_DOWNLOAD_SINK_H_
+
+#include <QtWidgets>
+#include <functional>
+#include <memory>
+
+namespace doogie {
+
+// Where a background download streams to. Each chunk is handed over as it
+// arrives so nothing ever has to hold the whole body. Sinks chain by
+// owning the next one: those that look at the data (checksums, lines) pass
+// it on as is, those that transform it (gzip, zip) pass on the result. A
+// sink is only ever used from one thread.
+class DownloadSink {
+ public:
+  virtual ~DownloadSink();
+
+  // False fails the download, ErrorString says why
+  virtual bool Write(const char* data, qint64 len);
+  // Called once after the last write if the download succeeded. False
+  //  fails it.
+  virtual bool Finish();
+  // Called instead of Finish if the download failed or was canceled
+  virtual void Abort();
+
+  QString ErrorString() const { return error_; }
+
+ protected:
+  explicit DownloadSink(DownloadSink* next = nullptr);
+
+  // Always returns false
+  bool Fail(const QString& error);
+  // Carries the next sink's error up on failure, true if there is no next
+  bool WriteNext(const char* data, qint64 len);
+
+  std::unique_ptr<DownloadSink> next_;
+
+ private:
+  QString error_;
+};
+
+// Writes to a temp file that only replaces the real one on Finish, so a
+// failed download never leaves a partial file behind.
+class FileDownloadSink : public DownloadSink {
+ public:
+  explicit FileDownloadSink(const QString& path);
+
+  bool Write(const char* data, qint64 len) override;
+  bool Finish() override;
+  void Abort() override;
+
+ private:
+  QSaveFile file_;
+};
+
+// Keeps the body in memory, failing if it gets bigger than max_size. For
+// small responses that have to be parsed as a whole.
+class BufferDownloadSink : public DownloadSink {
+ public:
+  explicit BufferDownloadSink(qint64 max_size);
+
+  bool Write(const char* data, qint64 len) override;
+
+  const QByteArray& Data() const { return data_; }
+
+ private:
+  qint64 max_size_;
+  QByteArray data_;
+};
+
+// Hashes everything that passes through.
+class ChecksumDownloadSink : public DownloadSink {
+ public:
+  explicit ChecksumDownloadSink(QCryptographicHash::Algorithm algorithm,
+                                DownloadSink* next = nullptr);
+
+  bool Write(const char* data, qint64 len) override;
+
+  // Only complete once finished
+  QByteArray Result() const { return hash_.result(); }
+
+ private:
+  QCryptographicHash hash_;
+};
+
+// Calls back w/ each UTF-8 line (w/out the line ending) as soon as it is
+// complete. The callback can return false to fail the download.
+class LineDownloadSink : public DownloadSink {
+ public:
+  explicit LineDownloadSink(std::function<bool(const QString&)> callback,
+                            DownloadSink* next = nullptr);
+
+  bool Write(const char* data, qint64 len) override;
+  bool Finish() override;
+
+ private:
+  bool EmitLine(const char* data, int len);
+
+  std::function<bool(const QString&)> callback_;
+  // The incomplete last line so far
+  QByteArray partial_;
+};
+
+// Inflates gzip or zlib data (detected from the header), or raw deflate
+// data, passing on what comes out. Anything after the end of the
+// compressed stream is ignored.
+class InflateDownloadSink : public DownloadSink {
+ public:
+  enum Format {
+    GzipOrZlib,
+    RawDeflate
+  };
+
+  explicit InflateDownloadSink(Format format, DownloadSink* next);
+  ~InflateDownloadSink();
+
+  bool Write(const char* data, qint64 len) override;
+  bool Finish() override;
+
+ private:
+  // Wraps zlib's stream so its header stays out of here
+  struct Stream;
+
+  std::unique_ptr<Stream> stream_;
+  bool ended_ = false;
+};
+
+// Passes on the contents of a single entry in a zip archive, skipping
+// everything else. Leading CRX (extension/component) headers are skipped
+// too. Only entries before the wanted one need known sizes, and only
+// stored and deflated entries can be extracted.
+class ZipEntryDownloadSink : public DownloadSink {
+ public:
+  explicit ZipEntryDownloadSink(const QString& entry_name,
+                                DownloadSink* next);
+
+  bool Write(const char* data, qint64 len) override;
+  bool Finish() override;
+
+ private:
+  static const int kLocalHeaderSize = 30;
+
+  enum State {
+    CrxMagic,
+    CrxHeader,
+    LocalHeader,
+    LocalHeaderNameAndExtra,
+    SkipEntry,
+    Entry,
+    Done
+  };
+
+  // Fills buffer_ to the given size from the data, false if not there yet
+  bool Buffer(const char** data, qint64* len, int size);
+  bool StartEntry();
+
+  QString entry_name_;
+  State state_ = CrxMagic;
+  bool found_ = false;
+  QByteArray buffer_;
+  // Whatever the state needs to wait for
+  qint64 wanted_ = 0;
+  // From the last local header
+  quint16 flags_ = 0;
+  quint16 method_ = 0;
+  quint32 compressed_size_ = 0;
+  int name_len_ = 0;
+};
+
+}  // namespace doogie
+
+#endif  // DOOGIE_DOWNLOAD_SINK_H_
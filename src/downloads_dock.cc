@@ -1,6 +1,7 @@
 #include "downloads_dock.h"
 
 #include "download_list_item.h"
+#include "metrics_registry.h"
 
 namespace doogie {
 
@@ -40,25 +41,18 @@ DownloadsDock::DownloadsDock(BrowserStack* browser_stack, QWidget* parent)
   widg->setLayout(layout);
   setWidget(widg);
 
-  auto add_or_update_download = [=](
-      const Download& download,
-      bool force_add = false) {
-    if (!force_add) {
-      for (int i = 0; i < list_->count(); i++) {
-        auto item = static_cast<DownloadListItem*>(list_->item(i));
-        if (item->UpdateDownload(download)) return;
-      }
+  auto add_or_update_download = [=](const Download& download) {
+    for (int i = 0; i < list_->count(); i++) {
+      auto item = static_cast<DownloadListItem*>(list_->item(i));
+      if (item->UpdateDownload(download)) return;
     }
-    auto item = new DownloadListItem;
-    list_->insertItem(0, item);
-    item->AfterAdded();
-    item->UpdateDownload(download);
+    InsertDownload(0, download);
   };
 
-  // Load all of the existing downloads
-  for (auto& download : Download::Downloads()) {
-    add_or_update_download(download, true);
-  }
+  // Past downloads can be many, so they wait until someone looks
+  connect(this, &QDockWidget::visibilityChanged, [=](bool visible) {
+    if (visible) LoadHistory();
+  });
 
   connect(remove_all_button, &QToolButton::clicked, [=]() {
     // Get all items, then delete em
@@ -110,6 +104,17 @@ DownloadsDock::DownloadsDock(BrowserStack* browser_stack, QWidget* parent)
     // We ignore downloads w/out a path (they force em to start early)
     if (!download.Path().isEmpty()) add_or_update_download(download);
   });
+
+  QPointer<DownloadsDock> self(this);
+  MetricsRegistry::SetGaugeCallback("download.user.active", [self]() {
+    qint64 active = 0;
+    if (!self) return active;
+    for (int i = 0; i < self->list_->count(); i++) {
+      auto item = static_cast<DownloadListItem*>(self->list_->item(i));
+      if (item->DownloadActive()) active++;
+    }
+    return active;
+  });
 }
 
 bool DownloadsDock::HasActiveDownload() {
@@ -121,4 +126,29 @@ bool DownloadsDock::HasActiveDownload() {
   return false;
 }
 
+void DownloadsDock::LoadHistory() {
+  if (history_loaded_) return;
+  history_loaded_ = true;
+  // Ones from this run are already here and also in the DB
+  QSet<qlonglong> present_ids;
+  for (int i = 0; i < list_->count(); i++) {
+    auto item = static_cast<DownloadListItem*>(list_->item(i));
+    if (item->CurrentDownload().Exists()) {
+      present_ids << item->CurrentDownload().DbId();
+    }
+  }
+  // Oldest first, each above the last but below the ones from this run
+  auto row = list_->count();
+  for (auto& download : Download::Downloads()) {
+    if (!present_ids.contains(download.DbId())) InsertDownload(row, download);
+  }
+}
+
+void DownloadsDock::InsertDownload(int row, const Download& download) {
+  auto item = new DownloadListItem;
+  list_->insertItem(row, item);
+  item->AfterAdded();
+  item->UpdateDownload(download);
+}
+
 }  // namespace doogie
@@ -15,9 +15,14 @@ class DownloadsDock : public QDockWidget {
                          QWidget* parent = nullptr);
 
   bool HasActiveDownload();
+  // Done on first show if not called before, does nothing after the first
+  void LoadHistory();
 
  private:
+  void InsertDownload(int row, const Download& download);
+
   QListWidget* list_;
+  bool history_loaded_ = false;
 };
 
 }  // namespace doogie
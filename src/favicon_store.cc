@@ -0,0 +1,109 @@
+#include "favicon_store.h"
+
+#include "sql.h"
+#include "sql_executor.h"
+#include "tracing.h"
+
+namespace doogie {
+
+QCache<qlonglong, FaviconStore::Known>* FaviconStore::known_ = nullptr;
+QCache<qlonglong, QPixmap>* FaviconStore::pixmaps_ = nullptr;
+
+QImage FaviconStore::ImageFromIcon(const QIcon& icon) {
+  if (icon.isNull()) return QImage();
+  // Same format every time so the same pixels give the same hash
+  return icon.pixmap(16, 16).toImage().convertToFormat(
+        QImage::Format_ARGB32_Premultiplied);
+}
+
+QVariant FaviconStore::Id(QSqlQuery* query, const QImage& image) {
+  Tracing::Span span("favicon", "Id");
+  if (image.isNull()) return QVariant(QVariant::LongLong);
+  auto hash = ImageHash(image);
+  // Same hash isn't enough, the pixels have to match too
+  auto known = known_ ? known_->object(hash) : nullptr;
+  if (known && known->image == image) return known->id;
+  // Only place we ever encode
+  QByteArray bytes;
+  QBuffer buffer(&bytes);
+  buffer.open(QIODevice::WriteOnly);
+  image.save(&buffer, "PNG");
+  if (!Sql::ExecParam(query,
+                      "SELECT id, data FROM favicon WHERE hash = ?",
+                      { hash })) {
+    return QVariant(QVariant::LongLong);
+  }
+  qlonglong id = -1;
+  while (id < 0 && query->next()) {
+    if (query->value(1).toByteArray() == bytes) {
+      id = query->value(0).toLongLong();
+    }
+  }
+  query->finish();
+  if (id < 0) {
+    auto ok = Sql::ExecParam(
+        query,
+        "INSERT INTO favicon (hash, data) VALUES (?, ?)",
+        { hash, bytes });
+    if (!ok) return QVariant(QVariant::LongLong);
+    id = query->lastInsertId().toLongLong();
+  }
+  // A rolled back insert mustn't be reused
+  SqlExecutor::AfterCommit([=]() {
+    if (!known_) known_ = new QCache<qlonglong, Known>(kKnownCacheSize);
+    known_->insert(hash, new Known { image, id });
+  });
+  return id;
+}
+
+int FaviconStore::DeleteUnused(QSqlQuery* query, int limit) {
+  auto ok = Sql::ExecParam(
+        query,
+        "DELETE FROM favicon WHERE id IN ( "
+        "  SELECT id FROM favicon WHERE ref_count <= 0 LIMIT ? "
+        ")",
+        { limit });
+  if (!ok) return -1;
+  auto deleted = query->numRowsAffected();
+  // We don't know which are gone, just reload as needed
+  if (deleted > 0 && known_) known_->clear();
+  return deleted;
+}
+
+QIcon FaviconStore::Icon(const QVariant& id) {
+  if (id.isNull() || !id.isValid()) return QIcon();
+  if (!pixmaps_) pixmaps_ = new QCache<qlonglong, QPixmap>(kPixmapCacheSize);
+  auto key = id.toLongLong();
+  auto pixmap = pixmaps_->object(key);
+  if (!pixmap) {
+    QSqlQuery query;
+    auto rec = Sql::ExecSingleParam(&query,
+                                    "SELECT data FROM favicon WHERE id = ?",
+                                    { key });
+    if (rec.isEmpty()) return QIcon();
+    pixmap = new QPixmap;
+    if (!pixmap->loadFromData(rec.value(0).toByteArray(), "PNG")) {
+      delete pixmap;
+      return QIcon();
+    }
+    pixmaps_->insert(key, pixmap);
+  }
+  return QIcon(*pixmap);
+}
+
+qlonglong FaviconStore::ImageHash(const QImage& image) {
+  // FNV-1a 64 bit over the pixels
+  quint64 hash = 14695981039346656037ull;
+  auto bits = image.constBits();
+  auto len = image.bytesPerLine() * image.height();
+  for (int i = 0; i < len; i++) {
+    hash = (hash ^ bits[i]) * 1099511628211ull;
+  }
+  // Include the size too, in case two images have the same bytes
+  hash = (hash ^ image.width()) * 1099511628211ull;
+  return static_cast<qlonglong>(hash);
+}
+
+FaviconStore::FaviconStore() { }
+
+}  // namespace doogie
@@ -0,0 +1,56 @@
+#ifndef DOOGIE_FAVICON_STORE_H_
+#define DOOGIE_FAVICON_STORE_H_
+
+#include <QtSql>
+#include <QtWidgets>
+
+namespace doogie {
+
+// Favicon storage shared by workspace pages and the page index. Images
+// are looked up by a hash of their pixels, then compared, so each distinct
+// image is only stored once no matter how many pages reference it.
+class FaviconStore {
+ public:
+  // Max decoded pixmaps to keep around
+  static const int kPixmapCacheSize = 300;
+  // Max stored images to remember the IDs of, past this they are looked
+  //  up in the DB
+  static const int kKnownCacheSize = 500;
+
+  // Must be called on the GUI thread. The result is what is stored and
+  //  can be handed to other threads.
+  static QImage ImageFromIcon(const QIcon& icon);
+
+  // Must be called on the writer thread. Gives the ID of the stored image,
+  //  storing it if not already there. Null ID for null images or failure.
+  static QVariant Id(QSqlQuery* query, const QImage& image);
+  // Must be called on the writer thread. Removes up to limit images no
+  //  longer referenced by any page (tracked by triggers). Returns the
+  //  amount deleted or -1 on failure.
+  static int DeleteUnused(QSqlQuery* query, int limit);
+
+  // Must be called on the GUI thread. Null icon if not found.
+  static QIcon Icon(const QVariant& id);
+
+ private:
+  struct Known {
+    QImage image;
+    qlonglong id;
+  };
+
+  static qlonglong ImageHash(const QImage& image);
+
+  // Keyed by image hash, LRU. Only the last stored image w/ a hash is
+  //  kept, others w/ the same hash go to the DB. Only touched on the
+  //  writer thread, and only w/ committed IDs. Created lazily.
+  static QCache<qlonglong, Known>* known_;
+  // Keyed by ID, LRU. Created lazily and never freed since pixmaps can't
+  //  outlive the app.
+  static QCache<qlonglong, QPixmap>* pixmaps_;
+
+  FaviconStore();
+};
+
+}  // namespace doogie
+
+#endif  // DOOGIE_FAVICON_STORE_H_
@@ -0,0 +1,156 @@
+#include "frecency_index.h"
+
+#include <algorithm>
+
+namespace doogie {
+
+FrecencyIndex::FrecencyIndex(int capacity) : capacity_(capacity) {
+  nodes_.append(Node());
+}
+
+void FrecencyIndex::Upsert(const Entry& entry) {
+  if (capacity_ <= 0) return;
+  if (entries_.contains(entry.id)) {
+    Remove(entry.id);
+  } else if (entries_.size() >= capacity_) {
+    // Something is outside the index now either way
+    complete_ = false;
+    auto lowest = ids_by_frecency_.constBegin();
+    if (lowest.key() >= entry.frecency) return;
+    Remove(lowest.value());
+  }
+  entries_.insert(entry.id, entry);
+  ids_by_url_.insert(entry.url, entry.id);
+  ids_by_frecency_.insert(entry.frecency, entry.id);
+  Index(entry, true);
+}
+
+void FrecencyIndex::Remove(qlonglong id) {
+  auto entry = entries_.find(id);
+  if (entry == entries_.end()) return;
+  Index(*entry, false);
+  ids_by_url_.remove(entry->url);
+  ids_by_frecency_.remove(entry->frecency, id);
+  entries_.erase(entry);
+  MaybeCompact();
+}
+
+void FrecencyIndex::RemoveVisitedBefore(qlonglong secs) {
+  QList<qlonglong> to_remove;
+  for (const auto& entry : entries_) {
+    if (entry.last_visited < secs) to_remove.append(entry.id);
+  }
+  for (auto id : to_remove) Remove(id);
+}
+
+void FrecencyIndex::UpdateTitle(const QString& url, const QString& title) {
+  auto id = ids_by_url_.value(url, -1);
+  if (id < 0) return;
+  auto entry = entries_[id];
+  if (entry.title == title) return;
+  Remove(id);
+  entry.title = title;
+  Upsert(entry);
+}
+
+void FrecencyIndex::UpdateFavicon(const QString& url,
+                                  const QVariant& favicon_id) {
+  auto id = ids_by_url_.value(url, -1);
+  if (id >= 0) entries_[id].favicon_id = favicon_id;
+}
+
+bool FrecencyIndex::Find(const QString& text,
+                         int count,
+                         QList<Entry>* results) const {
+  results->clear();
+  auto tokens = Tokens(Schemeless(text));
+  if (tokens.isEmpty()) return true;
+  // Every token has to prefix some token of the entry
+  QVector<const QSet<qlonglong>*> id_sets;
+  for (const auto& token : tokens) {
+    auto node = 0;
+    for (auto c : token) {
+      node = nodes_[node].children.value(c, -1);
+      if (node < 0) return complete_;
+    }
+    id_sets.append(&nodes_[node].ids);
+  }
+  std::sort(id_sets.begin(), id_sets.end(),
+            [](const QSet<qlonglong>* a, const QSet<qlonglong>* b) {
+    return a->size() < b->size();
+  });
+  QList<Entry> matches;
+  for (auto id : *id_sets.first()) {
+    auto all = true;
+    for (int i = 1; i < id_sets.size() && all; i++) {
+      all = id_sets[i]->contains(id);
+    }
+    if (all) matches.append(entries_[id]);
+  }
+  // If there are not enough and some pages aren't here, we can't be sure
+  if (matches.size() < count && !complete_) return false;
+  std::sort(matches.begin(), matches.end(),
+            [](const Entry& a, const Entry& b) {
+    return a.frecency > b.frecency;
+  });
+  *results = matches.mid(0, count);
+  return true;
+}
+
+QStringList FrecencyIndex::Tokens(const QString& str) {
+  QStringList ret;
+  QString curr;
+  for (auto c : str) {
+    if (c.isLetterOrNumber() || c == '-' || c == '_') {
+      curr += c.toLower();
+    } else if (!curr.isEmpty()) {
+      ret << curr;
+      curr.clear();
+    }
+  }
+  if (!curr.isEmpty()) ret << curr;
+  return ret;
+}
+
+QString FrecencyIndex::Schemeless(const QString& url) {
+  auto scheme_sep = url.indexOf("://");
+  return scheme_sep == -1 ? url : url.mid(scheme_sep + 3);
+}
+
+void FrecencyIndex::Index(const Entry& entry, bool add) {
+  QSet<QString> tokens;
+  for (const auto& token : Tokens(Schemeless(entry.url)) +
+       Tokens(entry.title)) {
+    tokens.insert(token);
+  }
+  for (const auto& token : tokens) {
+    auto node = 0;
+    for (auto c : token) {
+      auto child = nodes_[node].children.value(c, -1);
+      if (child < 0) {
+        if (!add) break;
+        child = nodes_.size();
+        nodes_[node].children.insert(c, child);
+        nodes_.append(Node());
+      }
+      node = child;
+      if (add) {
+        nodes_[node].ids.insert(entry.id);
+      } else {
+        nodes_[node].ids.remove(entry.id);
+      }
+    }
+    live_token_chars_ += add ? token.length() : -token.length();
+  }
+}
+
+void FrecencyIndex::MaybeCompact() {
+  // Meh, a full rebuild is cheap enough when it's this rare
+  if (nodes_.size() < 1024 || nodes_.size() < 4 * live_token_chars_) return;
+  nodes_.clear();
+  nodes_.append(Node());
+  live_token_chars_ = 0;
+  for (const auto& entry : entries_) Index(entry, true);
+}
+
+}  // namespace doogie
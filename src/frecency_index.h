@@ -0,0 +1,73 @@
+#ifndef DOOGIE_FRECENCY_INDEX_H_
+#define DOOGIE_FRECENCY_INDEX_H_
+
+#include <QtWidgets>
+
+namespace doogie {
+
+// In-memory index of the most frecent autocomplete pages. It's a prefix
+// trie over the tokens of the schemeless URL and title of each page so
+// most URL bar suggestions never need to hit the DB. It always holds the
+// top pages by frecency, so any match outside of it ranks lower than
+// everything in it. Not thread safe.
+class FrecencyIndex {
+ public:
+  struct Entry {
+    qlonglong id = -1;
+    QString url;
+    QString title;
+    QVariant favicon_id;
+    double frecency = 0;
+    qlonglong last_visited = 0;
+  };
+
+  explicit FrecencyIndex(int capacity);
+
+  int Capacity() const { return capacity_; }
+  int Size() const { return entries_.size(); }
+
+  // Set when every page is known to be in here, meaning fewer matches
+  //  than asked for is still a full answer
+  bool Complete() const { return complete_; }
+  void SetComplete(bool complete) { complete_ = complete; }
+
+  // Adds or replaces by ID, evicting the least frecent if full
+  void Upsert(const Entry& entry);
+  void Remove(qlonglong id);
+  void RemoveVisitedBefore(qlonglong secs);
+  void UpdateTitle(const QString& url, const QString& title);
+  void UpdateFavicon(const QString& url, const QVariant& favicon_id);
+
+  // Returns false if this index can't answer for sure, in which case the
+  //  caller should ask the DB
+  bool Find(const QString& text, int count, QList<Entry>* results) const;
+
+  // Lowercased FTS-like tokens (letters, numbers, '-' and '_')
+  static QStringList Tokens(const QString& str);
+
+ private:
+  struct Node {
+    QHash<QChar, int> children;
+    // Every entry that has a token w/ this node's prefix
+    QSet<qlonglong> ids;
+  };
+
+  static QString Schemeless(const QString& url);
+
+  void Index(const Entry& entry, bool add);
+  // Drops nodes left behind by removed entries once there are too many
+  void MaybeCompact();
+
+  int capacity_;
+  bool complete_ = false;
+  QHash<qlonglong, Entry> entries_;
+  QHash<QString, qlonglong> ids_by_url_;
+  QMultiMap<double, qlonglong> ids_by_frecency_;
+  // Root is always at 0
+  QVector<Node> nodes_;
+  int live_token_chars_ = 0;
+};
+
+}  // namespace doogie
+
+#endif  // DOOGIE_FRECENCY_INDEX_H_
@@ -0,0 +1,130 @@
+#include "log_file_sink.h"
+
+#include "metrics_registry.h"
+#include "profile.h"
+
+namespace doogie {
+
+QMutex LogFileSink::instance_mutex_;
+LogFileSink* LogFileSink::instance_ = nullptr;
+
+QString LogFileSink::ProfileLogDir() {
+  if (Profile::Current().InMemory()) return QString();
+  return QDir(Profile::Current().Path()).filePath("logs");
+}
+
+void LogFileSink::StartIfEnabled() {
+  auto dir = ProfileLogDir();
+  if (!dir.isNull() && QSettings().value("logging/fileSink").toBool()) {
+    Start(dir);
+  }
+}
+
+void LogFileSink::Start(const QString& dir) {
+  Stop();
+  QMutexLocker locker(&instance_mutex_);
+  instance_ = new LogFileSink(dir);
+  instance_->start(QThread::LowPriority);
+}
+
+void LogFileSink::Stop() {
+  LogFileSink* sink;
+  {
+    QMutexLocker locker(&instance_mutex_);
+    sink = instance_;
+    instance_ = nullptr;
+  }
+  // Deleting waits on it, and anything it logs meanwhile is not queued
+  delete sink;
+}
+
+bool LogFileSink::Running() {
+  QMutexLocker locker(&instance_mutex_);
+  return instance_ != nullptr;
+}
+
+void LogFileSink::Write(const LogStore::Entry& entry) {
+  static auto dropped = MetricsRegistry::GetCounter("log.fileSink.dropped");
+  QMutexLocker instance_locker(&instance_mutex_);
+  if (!instance_) return;
+  QMutexLocker locker(&instance_->mutex_);
+  if (instance_->queue_.size() >= kMaxQueued) {
+    instance_->dropped_++;
+    dropped->Increment();
+    return;
+  }
+  instance_->queue_.append(entry);
+  instance_->has_work_.wakeAll();
+}
+
+LogFileSink::~LogFileSink() {
+  {
+    QMutexLocker locker(&mutex_);
+    stopping_ = true;
+    has_work_.wakeAll();
+  }
+  wait();
+}
+
+void LogFileSink::run() {
+  QFile file(FilePath(0));
+  auto open = OpenFile(&file);
+  forever {
+    QVector<LogStore::Entry> batch;
+    auto dropped = 0;
+    {
+      QMutexLocker locker(&mutex_);
+      while (queue_.isEmpty() && !stopping_) has_work_.wait(&mutex_);
+      if (queue_.isEmpty()) break;
+      batch.swap(queue_);
+      dropped = dropped_;
+      dropped_ = 0;
+    }
+    // Still drained when we can't write so nobody waits on us
+    if (!open) continue;
+    QByteArray data;
+    if (dropped > 0) {
+      data += QString("%1 log entries dropped while writing\n").
+          arg(dropped).toUtf8();
+    }
+    for (const auto& entry : batch) {
+      data += LogStore::Format(entry).toUtf8();
+      data += '\n';
+    }
+    if (file.size() > 0 && file.size() + data.size() > kMaxFileSize) {
+      open = Rotate(&file);
+      if (!open) continue;
+    }
+    file.write(data);
+    file.flush();
+  }
+}
+
+LogFileSink::LogFileSink(const QString& dir) : dir_(dir) { }
+
+QString LogFileSink::FilePath(int index) const {
+  return QDir(dir_).filePath(index == 0 ? QString("doogie.log") :
+                                          QString("doogie.%1.log").arg(index));
+}
+
+bool LogFileSink::OpenFile(QFile* file) const {
+  if (!QDir().mkpath(dir_) ||
+      !file->open(QIODevice::WriteOnly | QIODevice::Append |
+                  QIODevice::Text)) {
+    // Only said once, this comes back around to us
+    qWarning() << "Unable to open log file" << file->fileName();
+    return false;
+  }
+  return true;
+}
+
+bool LogFileSink::Rotate(QFile* file) const {
+  file->close();
+  QFile::remove(FilePath(kMaxFiles - 1));
+  for (int i = kMaxFiles - 2; i >= 0; i--) {
+    if (QFile::exists(FilePath(i))) QFile::rename(FilePath(i), FilePath(i + 1));
+  }
+  return OpenFile(file);
+}
+
+}  // namespace doogie
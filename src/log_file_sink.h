@@ -0,0 +1,59 @@
+#ifndef DOOGIE_LOG_FILE_SINK_H_
+#define DOOGIE_LOG_FILE_SINK_H_
+
+#include <QtWidgets>
+
+#include "log_store.h"
+
+namespace doogie {
+
+// Background writer for log files. Whoever logs just queues the entry,
+// it's formatted and written in batches on our own thread. Once the file
+// would pass kMaxFileSize it's rotated to doogie.1.log and so on, keeping
+// kMaxFiles in all. If the queue backs up past kMaxQueued, entries are
+// dropped and a line saying how many is written instead.
+class LogFileSink : public QThread {
+ public:
+  static const qint64 kMaxFileSize = 5 * 1024 * 1024;
+  static const int kMaxFiles = 5;
+  static const int kMaxQueued = 10000;
+
+  // Under the current profile, null for in-memory ones
+  static QString ProfileLogDir();
+  // Starts in the profile's dir if turned on in the logs dock
+  static void StartIfEnabled();
+  // Stops any running one first
+  static void Start(const QString& dir);
+  // Writes everything still queued and stops the writer
+  static void Stop();
+  static bool Running();
+  // Any thread, does nothing when not running
+  static void Write(const LogStore::Entry& entry);
+
+  ~LogFileSink();
+
+ protected:
+  void run() override;
+
+ private:
+  explicit LogFileSink(const QString& dir);
+
+  QString FilePath(int index) const;
+  bool OpenFile(QFile* file) const;
+  bool Rotate(QFile* file) const;
+
+  // Guards the instance itself since any thread can log
+  static QMutex instance_mutex_;
+  static LogFileSink* instance_;
+
+  QString dir_;
+  QMutex mutex_;
+  QWaitCondition has_work_;
+  QVector<LogStore::Entry> queue_;
+  int dropped_ = 0;
+  bool stopping_ = false;
+};
+
+}  // namespace doogie
+
+#endif  // DOOGIE_LOG_FILE_SINK_H_
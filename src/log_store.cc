@@ -0,0 +1,82 @@
+#include "log_store.h"
+
+#include "log_file_sink.h"
+#include "metrics_registry.h"
+
+namespace doogie {
+
+QMutex LogStore::mutex_;
+QVector<LogStore::Entry> LogStore::entries_;
+int LogStore::oldest_ = 0;
+qint64 LogStore::next_seq_ = 0;
+
+void LogStore::Append(QtMsgType type,
+                      const char* category,
+                      const QString& message) {
+  static auto appended = MetricsRegistry::GetCounter("log.messages");
+  appended->Increment();
+  Entry entry {
+    0,
+    QDateTime::currentDateTime(),
+    type,
+    QString::fromLatin1(category ? category : "default"),
+    message
+  };
+  {
+    QMutexLocker locker(&mutex_);
+    entry.seq = next_seq_++;
+    if (entries_.size() < kMaxEntries) {
+      entries_.append(entry);
+    } else {
+      entries_[oldest_] = entry;
+      oldest_ = (oldest_ + 1) % kMaxEntries;
+    }
+  }
+  LogFileSink::Write(entry);
+}
+
+QVector<LogStore::Entry> LogStore::EntriesSince(qint64 seq) {
+  QMutexLocker locker(&mutex_);
+  QVector<Entry> ret;
+  if (seq >= next_seq_) return ret;
+  auto first_seq = next_seq_ - entries_.size();
+  auto skip = static_cast<int>(qMax(seq - first_seq, Q_INT64_C(0)));
+  ret.reserve(entries_.size() - skip);
+  for (auto i = skip; i < entries_.size(); i++) {
+    ret.append(entries_[(oldest_ + i) % entries_.size()]);
+  }
+  return ret;
+}
+
+int LogStore::Severity(QtMsgType type) {
+  switch (type) {
+    case QtDebugMsg: return 0;
+    case QtInfoMsg: return 1;
+    case QtWarningMsg: return 2;
+    case QtCriticalMsg: return 3;
+    case QtFatalMsg: return 4;
+  }
+  return 0;
+}
+
+QString LogStore::TypeName(QtMsgType type) {
+  switch (type) {
+    case QtDebugMsg: return "Debug";
+    case QtInfoMsg: return "Info";
+    case QtWarningMsg: return "Warning";
+    case QtCriticalMsg: return "Critical";
+    case QtFatalMsg: return "Fatal";
+  }
+  return "Unknown";
+}
+
+QString LogStore::Format(const Entry& entry) {
+  // All at once so a % in the message isn't taken as a placeholder
+  return QString("%1 [%2] %3: %4").arg(
+        entry.time.toString("yyyy-MM-dd HH:mm:ss.zzz"),
+        TypeName(entry.type), entry.category, entry.message);
+}
+
+LogStore::LogStore() { }
+
+}  // namespace doogie
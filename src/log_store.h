@@ -0,0 +1,50 @@
+#ifndef DOOGIE_LOG_STORE_H_
+#define DOOGIE_LOG_STORE_H_
+
+#include <QtWidgets>
+
+namespace doogie {
+
+// Keeps the last kMaxEntries log messages in a ring buffer. Appending is
+// thread safe and cheap, nothing is rendered or written here. Views pull
+// what's new by sequence number when they get around to it and the
+// LogFileSink, if running, gets each message handed to it as well.
+class LogStore {
+ public:
+  static const int kMaxEntries = 10000;
+
+  struct Entry {
+    // Increases by one per message ever appended
+    qint64 seq;
+    QDateTime time;
+    QtMsgType type;
+    QString category;
+    QString message;
+  };
+
+  // Any thread. A null category is "default" like Qt's own.
+  static void Append(QtMsgType type,
+                     const char* category,
+                     const QString& message);
+  // Oldest first. Ones that have already fallen out are just not there.
+  static QVector<Entry> EntriesSince(qint64 seq);
+
+  // Debug lowest, fatal highest, unlike the enum's own order
+  static int Severity(QtMsgType type);
+  static QString TypeName(QtMsgType type);
+  // Single line w/ time, level and category
+  static QString Format(const Entry& entry);
+
+ private:
+  static QMutex mutex_;
+  static QVector<Entry> entries_;
+  // Index of the oldest once full
+  static int oldest_;
+  static qint64 next_seq_;
+
+  LogStore();
+};
+
+}  // namespace doogie
+
+#endif  // DOOGIE_LOG_STORE_H_
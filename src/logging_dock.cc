@@ -1,25 +1,208 @@
 #include "logging_dock.h"
 
+#include <algorithm>
+
 #include "browser_widget.h"
+#include "log_file_sink.h"
+#include "log_store.h"
 
 namespace doogie {
 
+class LoggingDock::Model : public QAbstractListModel {
+ public:
+  explicit Model(QObject* parent) : QAbstractListModel(parent) { }
+
+  int rowCount(const QModelIndex& parent) const override {
+    return parent.isValid() ? 0 : entries_.size();
+  }
+
+  QVariant data(const QModelIndex& index, int role) const override {
+    if (!index.isValid() || index.row() >= entries_.size()) return QVariant();
+    const auto& entry = entries_[index.row()];
+    switch (role) {
+      case Qt::DisplayRole:
+        // Rows have to stay one line for the view to treat them uniformly
+        return LogStore::Format(entry).replace('\n', ' ');
+      case Qt::ToolTipRole:
+        return LogStore::Format(entry);
+      case Qt::ForegroundRole:
+        if (LogStore::Severity(entry.type) >=
+            LogStore::Severity(QtCriticalMsg)) {
+          return QBrush(Qt::red);
+        }
+        if (entry.type == QtWarningMsg) return QBrush(Qt::darkYellow);
+        return QVariant();
+    }
+    return QVariant();
+  }
+
+  // False if nothing new made it through the filter
+  bool Pull() {
+    auto entries = LogStore::EntriesSince(next_seq_);
+    if (entries.isEmpty()) return false;
+    next_seq_ = entries.last().seq + 1;
+    QList<LogStore::Entry> added;
+    for (const auto& entry : entries) {
+      if (!categories_.contains(entry.category)) {
+        categories_.append(entry.category);
+      }
+      if (Matches(entry)) added.append(entry);
+    }
+    if (added.isEmpty()) return false;
+    // Never more than the store holds, the oldest go first
+    auto excess = entries_.size() + added.size() - LogStore::kMaxEntries;
+    if (excess > 0) {
+      beginRemoveRows(QModelIndex(), 0, excess - 1);
+      entries_.erase(entries_.begin(), entries_.begin() + excess);
+      endRemoveRows();
+    }
+    beginInsertRows(QModelIndex(), entries_.size(),
+                    entries_.size() + added.size() - 1);
+    entries_.append(added);
+    endInsertRows();
+    return true;
+  }
+
+  // Null category for all
+  void SetFilter(int min_severity, const QString& category) {
+    min_severity_ = min_severity;
+    category_ = category;
+    beginResetModel();
+    entries_.clear();
+    next_seq_ = cleared_seq_;
+    endResetModel();
+    Pull();
+  }
+
+  void Clear() {
+    beginResetModel();
+    entries_.clear();
+    cleared_seq_ = next_seq_;
+    endResetModel();
+  }
+
+  QString Text(const QModelIndexList& indexes) const {
+    QStringList lines;
+    for (const auto& index : indexes) {
+      lines << LogStore::Format(entries_[index.row()]);
+    }
+    return lines.join('\n');
+  }
+
+  // Every one seen, not just shown, in the order seen
+  const QStringList& Categories() const { return categories_; }
+
+ private:
+  bool Matches(const LogStore::Entry& entry) const {
+    return LogStore::Severity(entry.type) >= min_severity_ &&
+        (category_.isNull() || entry.category == category_);
+  }
+
+  QList<LogStore::Entry> entries_;
+  qint64 next_seq_ = 0;
+  // Nothing before this is shown again after a clear
+  qint64 cleared_seq_ = 0;
+  int min_severity_ = 0;
+  QString category_;
+  QStringList categories_;
+};
+
 LoggingDock::LoggingDock(QWidget* parent) : QDockWidget("Logs", parent) {
-  text_edit_ = new QPlainTextEdit(this);
-  text_edit_->setReadOnly(true);
-  setWidget(text_edit_);
-}
+  setFeatures(QDockWidget::AllDockWidgetFeatures);
 
-void LoggingDock::Log(const QString &str) {
-  text_edit_->appendPlainText(str);
-  text_edit_->verticalScrollBar()->setValue(
-        text_edit_->verticalScrollBar()->maximum());
+  auto layout = new QVBoxLayout;
+
+  auto top_layout = new QHBoxLayout;
+  top_layout->addWidget(new QLabel("Level:"));
+  level_ = new QComboBox;
+  for (auto type : { QtDebugMsg, QtInfoMsg, QtWarningMsg, QtCriticalMsg }) {
+    level_->addItem(LogStore::TypeName(type), LogStore::Severity(type));
+  }
+  top_layout->addWidget(level_);
+  top_layout->addWidget(new QLabel("Category:"));
+  category_ = new QComboBox;
+  category_->addItem("All");
+  top_layout->addWidget(category_);
+  top_layout->addStretch(1);
+
+  auto file_sink = new QCheckBox("Write to Files");
+  auto log_dir = LogFileSink::ProfileLogDir();
+  if (log_dir.isNull()) {
+    file_sink->setEnabled(false);
+    file_sink->setToolTip("Not available for in-memory profiles");
+  } else {
+    file_sink->setToolTip("Write rotating log files to " +
+                          QDir::toNativeSeparators(log_dir));
+  }
+  file_sink->setChecked(LogFileSink::Running());
+  top_layout->addWidget(file_sink);
+
+  auto clear_button = new QToolButton;
+  clear_button->setToolTip("Clear Logs");
+  clear_button->setIcon(QIcon(":/res/images/fontawesome/ban.png"));
+  clear_button->setAutoRaise(true);
+  top_layout->addWidget(clear_button);
+
+  layout->addLayout(top_layout);
+
+  model_ = new Model(this);
+  view_ = new QListView;
+  // Lets the view skip measuring every row, so only the ones in view
+  //  are ever laid out
+  view_->setUniformItemSizes(true);
+  view_->setSelectionMode(QAbstractItemView::ExtendedSelection);
+  view_->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+  view_->setContextMenuPolicy(Qt::CustomContextMenu);
+  view_->setModel(model_);
+  layout->addWidget(view_, 1);
+
+  auto widg = new QWidget;
+  widg->setLayout(layout);
+  setWidget(widg);
+
+  connect(level_, static_cast<void(QComboBox::*)(int)>(
+              &QComboBox::currentIndexChanged),
+          [=](int) { ApplyFilter(); });
+  connect(category_, static_cast<void(QComboBox::*)(int)>(
+              &QComboBox::currentIndexChanged),
+          [=](int) { ApplyFilter(); });
+  connect(file_sink, &QCheckBox::toggled, [=](bool checked) {
+    QSettings().setValue("logging/fileSink", checked);
+    if (checked) {
+      LogFileSink::Start(log_dir);
+    } else {
+      LogFileSink::Stop();
+    }
+  });
+  connect(clear_button, &QToolButton::clicked, [=](bool) {
+    model_->Clear();
+  });
+  connect(view_, &QListView::customContextMenuRequested,
+          [=](const QPoint& pos) {
+    QMenu menu;
+    auto selected = view_->selectionModel()->selectedRows();
+    std::sort(selected.begin(), selected.end());
+    menu.addAction("Copy", [=]() {
+      QApplication::clipboard()->setText(model_->Text(selected));
+    })->setEnabled(!selected.isEmpty());
+    menu.addAction("Clear", [=]() { clear_button->click(); });
+    menu.exec(view_->mapToGlobal(pos));
+  });
+
+  // Nothing is done for new messages while hidden
+  connect(&refresh_timer_, &QTimer::timeout, this, &LoggingDock::Refresh);
+  connect(this, &QDockWidget::visibilityChanged, [=](bool visible) {
+    if (visible) {
+      Refresh();
+      refresh_timer_.start(kRefreshMs);
+    } else {
+      refresh_timer_.stop();
+    }
+  });
 }
 
-void LoggingDock::LogQtMessage(QtMsgType,
-                               const QMessageLogContext&,
-                               const QString& str) {
-  Log(str);
+void LoggingDock::Log(const QString &str) {
+  LogStore::Append(QtInfoMsg, nullptr, str);
 }
 
 void LoggingDock::LogWidgetMessage(const QString& str, QWidget* source) {
@@ -32,4 +215,22 @@ void LoggingDock::LogWidgetMessage(const QString& str, QWidget* source) {
   }
 }
 
+void LoggingDock::Refresh() {
+  // Only follow along if they haven't scrolled up
+  auto scroll_bar = view_->verticalScrollBar();
+  auto at_bottom = scroll_bar->value() == scroll_bar->maximum();
+  if (model_->Pull() && at_bottom) view_->scrollToBottom();
+  for (const auto& category : model_->Categories()) {
+    if (category_->findData(category) < 0) {
+      category_->addItem(category, category);
+    }
+  }
+}
+
+void LoggingDock::ApplyFilter() {
+  model_->SetFilter(level_->currentData().toInt(),
+                    category_->currentData().toString());
+  view_->scrollToBottom();
+}
+
 }  // namespace doogie
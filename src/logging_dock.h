@@ -5,20 +5,31 @@
 
 namespace doogie {
 
-// Dock window for showing internal log messages.
+// Dock window for showing internal log messages. The messages live in the
+// LogStore, this just pulls what's new every so often while shown and only
+// draws the lines in view.
 class LoggingDock : public QDockWidget {
   Q_OBJECT
 
  public:
   explicit LoggingDock(QWidget* parent = nullptr);
   void Log(const QString& str);
-  void LogQtMessage(QtMsgType type,
-                    const QMessageLogContext& ctx,
-                    const QString& str);
   void LogWidgetMessage(const QString& str, QWidget* source);
 
  private:
-  QPlainTextEdit* text_edit_;
+  static const int kRefreshMs = 250;
+
+  // Filtered view of the store, defined w/ the rest
+  class Model;
+
+  void Refresh();
+  void ApplyFilter();
+
+  Model* model_;
+  QListView* view_;
+  QComboBox* level_;
+  QComboBox* category_;
+  QTimer refresh_timer_;
 };
 
 }  // namespace doogie
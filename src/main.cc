@@ -2,15 +2,24 @@
 
 #include "action_manager.h"
 #include "cef/cef.h"
+#include "log_file_sink.h"
 #include "main_window.h"
+#include "metrics_server.h"
+#include "page_index.h"
+#include "sql_executor.h"
+#include "startup_profile.h"
+#include "tracing.h"
 #include "updater.h"
 #include "util.h"
+#include "workspace.h"
 
 #ifdef QT_DEBUG
 #include "debug_meta_server.h"
 #endif
 
 int main(int argc, char* argv[]) {
+  doogie::StartupProfile::Begin();
+
   // We have to set the library path to the exe dir, but we can't use something
   //  like QCoreApplication::applicationDirPath because it requires that we
   //  have an application created already which we don't (and don't want to
@@ -25,22 +34,52 @@ int main(int argc, char* argv[]) {
   doogie::Cef cef(argc, argv);
   if (cef.EarlyExitCode() >= 0) return cef.EarlyExitCode();
 
+  // Slow startups can be traced from the very beginning, which is before
+  //  there's an app to ask for the args
+  for (int i = 1; i < argc; i++) {
+    if (qstrcmp(argv[i], "--trace") == 0) {
+      doogie::Tracing::Start(true);
+      break;
+    }
+  }
+
   QApplication app(argc, argv);
   QCoreApplication::setOrganizationName("cretz");
   QCoreApplication::setApplicationName("Doogie");
   doogie::ActionManager::CreateInstance(&app);
+  doogie::LogFileSink::StartIfEnabled();
+  {
+    doogie::StartupProfile::PhaseTimer phase("frecencyIndex");
+    doogie::PageIndex::LoadFrecencyIndex();
+  }
 
   // Creating this is enough to start it
+  doogie::StartupProfile::PhaseTimer updater_phase("updater");
   doogie::Updater updater(cef);
+  updater_phase.End();
 
+  doogie::StartupProfile::PhaseTimer window_phase("mainWindow");
   doogie::MainWindow win(cef);
   win.show();
   win.activateWindow();
   win.raise();
+  window_phase.End();
+  // Done once the event loop turns w/ the window up
+  QTimer::singleShot(0, []() { doogie::StartupProfile::Finish(); });
 
 #ifdef QT_DEBUG
   doogie::DebugMetaServer meta_server(&win);
 #endif
 
-  return app.exec();
+  // Only when asked for, e.g. by soak tests against release builds
+  auto metrics_name = doogie::MetricsServer::NameFromArgs(app.arguments());
+  if (!metrics_name.isNull()) new doogie::MetricsServer(metrics_name, &app);
+
+  auto ret = app.exec();
+  // Make sure everything held or queued gets written
+  doogie::Workspace::WorkspacePage::FlushPendingUpdates();
+  doogie::PageIndex::FlushPendingVisits();
+  doogie::SqlExecutor::Stop();
+  doogie::LogFileSink::Stop();
+  return ret;
 }
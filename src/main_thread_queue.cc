@@ -0,0 +1,141 @@
+#include "main_thread_queue.h"
+
+#include <chrono>
+
+#include "metrics_registry.h"
+
+namespace doogie {
+
+std::atomic<MainThreadQueue*> MainThreadQueue::instance_ { nullptr };
+
+void MainThreadQueue::Post(std::function<void()> fn) {
+  auto node = new Node;
+  node->fn = std::move(fn);
+  node->enqueued_at_us = NowUs();
+  Instance()->Push(node);
+}
+
+MainThreadQueue::Stats MainThreadQueue::CurrentStats() {
+  auto queue = Instance();
+  Stats stats;
+  stats.depth = queue->depth_.load();
+  stats.max_depth = queue->max_depth_.load();
+  stats.tasks_run = queue->tasks_run_;
+  stats.batches_run = queue->batches_run_;
+  stats.last_latency_us = queue->last_latency_us_;
+  stats.max_latency_us = queue->max_latency_us_;
+  return stats;
+}
+
+bool MainThreadQueue::event(QEvent* event) {
+  if (event->type() != drain_event_type_) return QObject::event(event);
+  Drain();
+  return true;
+}
+
+MainThreadQueue* MainThreadQueue::Instance() {
+  auto queue = instance_.load(std::memory_order_acquire);
+  if (queue) return queue;
+  // Two threads can race to get here first, only one wins
+  auto created = new MainThreadQueue;
+  created->moveToThread(QCoreApplication::instance()->thread());
+  if (!instance_.compare_exchange_strong(queue, created)) {
+    delete created;
+    return queue;
+  }
+  // Never deleted, posted events could still be on their way
+  return created;
+}
+
+qint64 MainThreadQueue::NowUs() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+MainThreadQueue::MainThreadQueue()
+    : drain_event_type_(static_cast<QEvent::Type>(QEvent::registerEventType())),
+      head_(&stub_),
+      tail_(&stub_) {
+  MetricsRegistry::SetGaugeCallback("mainQueue.depth", []() {
+    return CurrentStats().depth;
+  });
+  MetricsRegistry::SetGaugeCallback("mainQueue.maxDepth", []() {
+    return CurrentStats().max_depth;
+  });
+  MetricsRegistry::SetGaugeCallback("mainQueue.tasksRun", []() {
+    return CurrentStats().tasks_run;
+  });
+  MetricsRegistry::SetGaugeCallback("mainQueue.batchesRun", []() {
+    return CurrentStats().batches_run;
+  });
+  MetricsRegistry::SetGaugeCallback("mainQueue.lastLatencyUs", []() {
+    return CurrentStats().last_latency_us;
+  });
+  MetricsRegistry::SetGaugeCallback("mainQueue.maxLatencyUs", []() {
+    return CurrentStats().max_latency_us;
+  });
+}
+
+void MainThreadQueue::Push(Node* node) {
+  auto depth = ++depth_;
+  auto max = max_depth_.load(std::memory_order_relaxed);
+  while (depth > max && !max_depth_.compare_exchange_weak(max, depth)) { }
+  // Vyukov style, the swap is the only point of contention
+  auto prev = head_.exchange(node, std::memory_order_acq_rel);
+  prev->next.store(node, std::memory_order_release);
+  // Only the first producer since the last drain started posts
+  if (!drain_posted_.exchange(true)) {
+    QCoreApplication::postEvent(this, new QEvent(drain_event_type_));
+  }
+}
+
+MainThreadQueue::Node* MainThreadQueue::Pop() {
+  auto tail = tail_;
+  auto next = tail->next.load(std::memory_order_acquire);
+  if (tail == &stub_) {
+    if (!next) return nullptr;
+    tail_ = next;
+    tail = next;
+    next = next->next.load(std::memory_order_acquire);
+  }
+  if (next) {
+    tail_ = next;
+    return tail;
+  }
+  if (tail != head_.load(std::memory_order_acquire)) return nullptr;
+  // Last one, put the stub back behind it so we can take it
+  stub_.next.store(nullptr, std::memory_order_relaxed);
+  auto prev = head_.exchange(&stub_, std::memory_order_acq_rel);
+  prev->next.store(&stub_, std::memory_order_release);
+  next = tail->next.load(std::memory_order_acquire);
+  if (!next) return nullptr;
+  tail_ = next;
+  return tail;
+}
+
+void MainThreadQueue::Drain() {
+  // Anything pushed from here on posts a new drain
+  drain_posted_.store(false);
+  batches_run_++;
+  QElapsedTimer timer;
+  timer.start();
+  while (auto node = Pop()) {
+    depth_--;
+    last_latency_us_ = NowUs() - node->enqueued_at_us;
+    max_latency_us_ = qMax(max_latency_us_, last_latency_us_);
+    tasks_run_++;
+    // Taken out first, the task could run a nested event loop that
+    //  drains more
+    auto fn = std::move(node->fn);
+    delete node;
+    fn();
+    if (timer.elapsed() >= kMaxDrainMs) {
+      if (!drain_posted_.exchange(true)) {
+        QCoreApplication::postEvent(this, new QEvent(drain_event_type_));
+      }
+      return;
+    }
+  }
+}
+
+}  // namespace doogie
@@ -0,0 +1,79 @@
+#ifndef DOOGIE_MAIN_THREAD_QUEUE_H_
+#define DOOGIE_MAIN_THREAD_QUEUE_H_
+
+#include <QtWidgets>
+
+#include <atomic>
+#include <functional>
+
+namespace doogie {
+
+// Lock-free multi-producer, single-consumer queue of tasks for the GUI
+// thread. Producers never block and at most one event is posted per
+// batch no matter how many tasks are queued in the meantime.
+class MainThreadQueue : public QObject {
+  Q_OBJECT
+
+ public:
+  // Tasks run longer than this in one event are continued in the next so
+  //  input and paints get a chance to be handled
+  static const int kMaxDrainMs = 10;
+
+  struct Stats {
+    qint64 depth = 0;
+    qint64 max_depth = 0;
+    qint64 tasks_run = 0;
+    qint64 batches_run = 0;
+    // Time from enqueue to run
+    qint64 last_latency_us = 0;
+    qint64 max_latency_us = 0;
+  };
+
+  // Can be called from any thread. Must not be called before the Qt
+  //  application is created.
+  static void Post(std::function<void()> fn);
+
+  // Must be called on the GUI thread
+  static Stats CurrentStats();
+
+ protected:
+  bool event(QEvent* event) override;
+
+ private:
+  struct Node {
+    std::atomic<Node*> next { nullptr };
+    std::function<void()> fn;
+    qint64 enqueued_at_us = 0;
+  };
+
+  static MainThreadQueue* Instance();
+  static qint64 NowUs();
+
+  MainThreadQueue();
+
+  void Push(Node* node);
+  // Null if empty or if a producer is still mid push, in which case
+  //  that producer will post another drain
+  Node* Pop();
+  void Drain();
+
+  static std::atomic<MainThreadQueue*> instance_;
+
+  const QEvent::Type drain_event_type_;
+  // Producers swap themselves in here, the consumer reads from tail_
+  std::atomic<Node*> head_;
+  Node* tail_;
+  Node stub_;
+  std::atomic<bool> drain_posted_ { false };
+  std::atomic<qint64> depth_ { 0 };
+  std::atomic<qint64> max_depth_ { 0 };
+  // Only touched on the GUI thread
+  qint64 tasks_run_ = 0;
+  qint64 batches_run_ = 0;
+  qint64 last_latency_us_ = 0;
+  qint64 max_latency_us_ = 0;
+};
+
+}  // namespace doogie
+
+#endif  // DOOGIE_MAIN_THREAD_QUEUE_H_
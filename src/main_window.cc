@@ -2,9 +2,12 @@
 
 #include "action_manager.h"
 #include "browser_stack.h"
+#include "log_store.h"
 #include "profile.h"
 #include "profile_change_dialog.h"
 #include "profile_settings_dialog.h"
+#include "startup_profile.h"
+#include "tracing.h"
 #include "util.h"
 
 namespace doogie {
@@ -15,12 +18,6 @@ MainWindow::MainWindow(const Cef& cef, QWidget* parent)
     : QMainWindow(parent), cef_(cef) {
   if (instance_ == nullptr) instance_ = this;
 
-  // TODO(cretz): how to determine best interval
-  // TODO(cretz): is the timer stopped for us?
-  if (startTimer(10) == 0) {
-    throw std::runtime_error("Unable to start CEF timer");
-  }
-
   // Common settings
   setWindowTitle("Doogie");
   setFocusPolicy(Qt::FocusPolicy::StrongFocus);
@@ -43,16 +40,23 @@ MainWindow::MainWindow(const Cef& cef, QWidget* parent)
     launch_with_profile_on_close_ = "";
   });
 
+  StartupProfile::PhaseTimer downloads_phase("downloadsDock");
   downloads_dock_ = new DownloadsDock(browser_stack_, this);
   downloads_dock_->setObjectName("downloads_dock");
   downloads_dock_->setVisible(false);
   addDockWidget(Qt::LeftDockWidgetArea, downloads_dock_);
+  // The history is only needed once the dock is shown
+  if (!StartupProfile::FastStart()) downloads_dock_->LoadHistory();
+  downloads_phase.End();
 
+  StartupProfile::PhaseTimer blocker_phase("blockerDock");
   blocker_dock_ = new BlockerDock(cef, browser_stack_, this);
   blocker_dock_->setObjectName("blocker_dock");
   blocker_dock_->setVisible(false);
   addDockWidget(Qt::BottomDockWidgetArea, blocker_dock_);
+  blocker_phase.End();
 
+  StartupProfile::PhaseTimer page_tree_phase("pageTreeDock");
   page_tree_dock_ = new PageTreeDock(browser_stack_, this);
   page_tree_dock_->setObjectName("page_tree_dock");
   addDockWidget(Qt::LeftDockWidgetArea, page_tree_dock_);
@@ -66,6 +70,7 @@ MainWindow::MainWindow(const Cef& cef, QWidget* parent)
       QTimer::singleShot(0, [=]() { close(); });
     }
   });
+  page_tree_phase.End();
 
   dev_tools_dock_ = new DevToolsDock(cef, browser_stack_, this);
   dev_tools_dock_->setObjectName("dev_tools_dock");
@@ -97,6 +102,7 @@ MainWindow::MainWindow(const Cef& cef, QWidget* parent)
   SetupActions();
 
   // Restore the window state
+  StartupProfile::PhaseTimer restore_phase("restoreState");
   QSettings settings;
   restoreGeometry(settings.value("mainWin/geom").toByteArray());
   restoreState(settings.value("mainWin/state").toByteArray(),
@@ -220,16 +226,12 @@ void MainWindow::keyPressEvent(QKeyEvent* event) {
   QMainWindow::keyPressEvent(event);
 }
 
-void MainWindow::timerEvent(QTimerEvent*) {
-  cef_.Tick();
-}
-
 void MainWindow::LogQtMessage(QtMsgType type,
                               const QMessageLogContext& ctx,
                               const QString& str) {
-  // We accept the lack of thread safety here
-  auto inst = MainWindow::instance_;
-  if (inst) inst->logging_dock_->LogQtMessage(type, ctx, str);
+  // Can be any thread, the store is safe for that and the dock pulls
+  //  from it on its own time
+  LogStore::Append(type, ctx.category, str);
 }
 
 void MainWindow::SetupActions() {
@@ -287,6 +289,45 @@ void MainWindow::SetupActions() {
     logs_action->setChecked(visible);
   });
 
+  auto trace_action = ActionManager::Action(ActionManager::ToggleTracing);
+  trace_action->setCheckable(true);
+  // May have been started from the command line
+  trace_action->setChecked(Tracing::Recording());
+  connect(trace_action, &QAction::triggered, [=](bool checked) {
+    if (checked) {
+      auto include_chromium =
+          QSettings().value("tracing/includeChromium", true).toBool();
+      if (!Tracing::Start(include_chromium)) {
+        trace_action->setChecked(false);
+        QMessageBox::critical(nullptr, "Trace Error",
+                              "Unable to start tracing");
+      }
+      return;
+    }
+    auto path = QFileDialog::getSaveFileName(
+          this, "Save Trace As...",
+          QDir(QStandardPaths::writableLocation(
+              QStandardPaths::DocumentsLocation)).filePath("doogie-trace.json"),
+          "Trace Files (*.json)");
+    // Keep going if they didn't pick anywhere
+    if (path.isEmpty()) {
+      trace_action->setChecked(true);
+      return;
+    }
+    Tracing::Stop(path, [=](bool ok) {
+      if (!ok) {
+        QMessageBox::critical(nullptr, "Trace Error",
+                              "Unable to save trace to " + path);
+      }
+    });
+  });
+
+  connect(ActionManager::Action(ActionManager::StartupTimings),
+          &QAction::triggered, [=]() {
+    QMessageBox::information(this, "Startup Timings",
+                             StartupProfile::Summary());
+  });
+
   // Shortcut keys
   Profile::Current().ApplyActionShortcuts();
 
@@ -322,6 +363,8 @@ void MainWindow::SetupActions() {
   menu_action(menu, ActionManager::LogsWindow);
   menu_action(menu, ActionManager::DownloadsWindow);
   menu_action(menu, ActionManager::BlockerWindow);
+  menu_action(menu, ActionManager::ToggleTracing);
+  menu_action(menu, ActionManager::StartupTimings);
 
   // Non-visible actions
   addAction(ActionManager::Action(ActionManager::NewChildBackgroundPage));
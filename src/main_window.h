@@ -33,7 +33,6 @@ class MainWindow : public QMainWindow {
   void dropEvent(QDropEvent* event) override;
   void dragEnterEvent(QDragEnterEvent* event) override;
   void keyPressEvent(QKeyEvent* event) override;
-  void timerEvent(QTimerEvent* event) override;
 
  private:
   static const int kStateVersion = 1;
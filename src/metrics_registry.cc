@@ -0,0 +1,135 @@
+#include "metrics_registry.h"
+
+#include <cmath>
+
+namespace doogie {
+
+QMutex MetricsRegistry::mutex_;
+QMap<QString, MetricsRegistry::Counter*> MetricsRegistry::counters_;
+QMap<QString, MetricsRegistry::Gauge*> MetricsRegistry::gauges_;
+QMap<QString, MetricsRegistry::Histogram*> MetricsRegistry::histograms_;
+QMap<QString, std::function<qint64()>> MetricsRegistry::gauge_callbacks_;
+
+void MetricsRegistry::Histogram::Record(qint64 us) {
+  if (us < 0) us = 0;
+  // Bucket i holds values < 2^i
+  auto bucket = 0;
+  while (bucket < kBuckets - 1 && (us >> bucket) > 0) bucket++;
+  auto& shard = shards_[ThreadShard()];
+  shard.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+  shard.count.fetch_add(1, std::memory_order_relaxed);
+  shard.sum_us.fetch_add(us, std::memory_order_relaxed);
+  // Rarely loops, the shard is almost always only ours
+  auto max = shard.max_us.load(std::memory_order_relaxed);
+  while (us > max && !shard.max_us.compare_exchange_weak(
+             max, us, std::memory_order_relaxed)) { }
+}
+
+MetricsRegistry::Histogram::Summary
+    MetricsRegistry::Histogram::Summarize() const {
+  Summary ret;
+  qint64 buckets[kBuckets] = {};
+  for (const auto& shard : shards_) {
+    for (int i = 0; i < kBuckets; i++) {
+      buckets[i] += shard.buckets[i].load(std::memory_order_relaxed);
+    }
+    ret.count += shard.count.load(std::memory_order_relaxed);
+    ret.sum_us += shard.sum_us.load(std::memory_order_relaxed);
+    ret.max_us = qMax(ret.max_us,
+                      shard.max_us.load(std::memory_order_relaxed));
+  }
+  // Not exact, shards may be written while we read, but close enough
+  auto percentile = [&](double pct) -> qint64 {
+    auto wanted = static_cast<qint64>(std::ceil(ret.count * pct));
+    qint64 seen = 0;
+    for (int i = 0; i < kBuckets; i++) {
+      seen += buckets[i];
+      if (seen >= wanted && seen > 0) {
+        return qMin(ret.max_us, (Q_INT64_C(1) << i) - 1);
+      }
+    }
+    return ret.max_us;
+  };
+  ret.p50_us = percentile(0.5);
+  ret.p90_us = percentile(0.9);
+  ret.p99_us = percentile(0.99);
+  return ret;
+}
+
+int MetricsRegistry::Histogram::ThreadShard() {
+  static std::atomic<int> next_shard { 0 };
+  thread_local int shard = next_shard.fetch_add(1) % kShards;
+  return shard;
+}
+
+MetricsRegistry::Counter* MetricsRegistry::GetCounter(const QString& name) {
+  QMutexLocker locker(&mutex_);
+  auto& ret = counters_[name];
+  if (!ret) ret = new Counter;
+  return ret;
+}
+
+MetricsRegistry::Gauge* MetricsRegistry::GetGauge(const QString& name) {
+  QMutexLocker locker(&mutex_);
+  auto& ret = gauges_[name];
+  if (!ret) ret = new Gauge;
+  return ret;
+}
+
+MetricsRegistry::Histogram* MetricsRegistry::GetHistogram(
+    const QString& name) {
+  QMutexLocker locker(&mutex_);
+  auto& ret = histograms_[name];
+  if (!ret) ret = new Histogram;
+  return ret;
+}
+
+void MetricsRegistry::SetGaugeCallback(const QString& name,
+                                       std::function<qint64()> callback) {
+  QMutexLocker locker(&mutex_);
+  gauge_callbacks_[name] = callback;
+}
+
+QJsonObject MetricsRegistry::Snapshot() {
+  QJsonObject counters;
+  QJsonObject gauges;
+  QJsonObject histograms;
+  QMap<QString, std::function<qint64()>> callbacks;
+  {
+    QMutexLocker locker(&mutex_);
+    for (auto it = counters_.constBegin(); it != counters_.constEnd(); it++) {
+      counters[it.key()] = (*it)->Value();
+    }
+    for (auto it = gauges_.constBegin(); it != gauges_.constEnd(); it++) {
+      gauges[it.key()] = (*it)->Value();
+    }
+    for (auto it = histograms_.constBegin();
+         it != histograms_.constEnd();
+         it++) {
+      auto summary = (*it)->Summarize();
+      histograms[it.key()] = QJsonObject {
+        { "count", summary.count },
+        { "sumUs", summary.sum_us },
+        { "maxUs", summary.max_us },
+        { "p50Us", summary.p50_us },
+        { "p90Us", summary.p90_us },
+        { "p99Us", summary.p99_us }
+      };
+    }
+    callbacks = gauge_callbacks_;
+  }
+  // Outside the lock, these may well want to look up metrics themselves
+  for (auto it = callbacks.constBegin(); it != callbacks.constEnd(); it++) {
+    gauges[it.key()] = (*it)();
+  }
+  return {
+    { "time", QDateTime::currentDateTimeUtc().toString(Qt::ISODateWithMs) },
+    { "counters", counters },
+    { "gauges", gauges },
+    { "histograms", histograms }
+  };
+}
+
+MetricsRegistry::MetricsRegistry() { }
+
+}  // namespace doogie
@@ -0,0 +1,117 @@
+#ifndef DOOGIE_METRICS_REGISTRY_H_
+#define DOOGIE_METRICS_REGISTRY_H_
+
+#include <QtWidgets>
+
+#include <atomic>
+#include <functional>
+
+namespace doogie {
+
+// Process-wide named counters, gauges and latency histograms. Looking one
+// up takes a lock so callers keep the pointer (usually in a function-local
+// static), but updating one is lock free and safe from any thread. Metrics
+// are never removed.
+class MetricsRegistry {
+ public:
+  class Counter {
+   public:
+    void Increment(qint64 by = 1) {
+      value_.fetch_add(by, std::memory_order_relaxed);
+    }
+    qint64 Value() const { return value_.load(std::memory_order_relaxed); }
+
+   private:
+    std::atomic<qint64> value_ { 0 };
+  };
+
+  class Gauge {
+   public:
+    void Set(qint64 value) { value_.store(value, std::memory_order_relaxed); }
+    void Add(qint64 by) { value_.fetch_add(by, std::memory_order_relaxed); }
+    qint64 Value() const { return value_.load(std::memory_order_relaxed); }
+
+   private:
+    std::atomic<qint64> value_ { 0 };
+  };
+
+  // Microsecond values in power of two buckets. Each thread records into
+  // its own shard (well, threads share them round robin past kShards) so
+  // hot paths on different threads don't fight over cache lines. Shards
+  // are only added up when read.
+  class Histogram {
+   public:
+    // Up to ~35 minutes, anything bigger goes in the last bucket
+    static const int kBuckets = 32;
+    static const int kShards = 8;
+
+    struct Summary {
+      qint64 count = 0;
+      qint64 sum_us = 0;
+      qint64 max_us = 0;
+      // Upper bounds of the buckets they fall in
+      qint64 p50_us = 0;
+      qint64 p90_us = 0;
+      qint64 p99_us = 0;
+    };
+
+    void Record(qint64 us);
+    Summary Summarize() const;
+
+   private:
+    struct Shard {
+      std::atomic<qint64> buckets[kBuckets];
+      std::atomic<qint64> count;
+      std::atomic<qint64> sum_us;
+      std::atomic<qint64> max_us;
+      // Keeps the next shard off of our last cache line. Not alignas since
+      //  C++14 new doesn't honor it.
+      char padding[64];
+    };
+
+    static int ThreadShard();
+
+    Shard shards_[kShards] = {};
+  };
+
+  // Records the time from creation to destruction
+  class ScopedTimer {
+   public:
+    explicit ScopedTimer(Histogram* histogram) : histogram_(histogram) {
+      timer_.start();
+    }
+    ~ScopedTimer() { histogram_->Record(timer_.nsecsElapsed() / 1000); }
+
+   private:
+    Histogram* histogram_;
+    QElapsedTimer timer_;
+    Q_DISABLE_COPY(ScopedTimer)
+  };
+
+  // Names are dotted camel case, e.g. "sql.writer.queueDepth". Asking for
+  //  the same name again gives the same one.
+  static Counter* GetCounter(const QString& name);
+  static Gauge* GetGauge(const QString& name);
+  static Histogram* GetHistogram(const QString& name);
+  // For values owned elsewhere. Only called when a snapshot is taken,
+  //  which is on the GUI thread. Replaces any previous one w/ the name.
+  static void SetGaugeCallback(const QString& name,
+                               std::function<qint64()> callback);
+
+  // Must be called on the GUI thread
+  static QJsonObject Snapshot();
+
+ private:
+  // Values are never freed since callers hold on to them forever
+  static QMutex mutex_;
+  static QMap<QString, Counter*> counters_;
+  static QMap<QString, Gauge*> gauges_;
+  static QMap<QString, Histogram*> histograms_;
+  static QMap<QString, std::function<qint64()>> gauge_callbacks_;
+
+  MetricsRegistry();
+};
+
+}  // namespace doogie
+
+#endif  // DOOGIE_METRICS_REGISTRY_H_
@@ -0,0 +1,58 @@
+#include "metrics_server.h"
+
+#include "metrics_registry.h"
+
+namespace doogie {
+
+const QString MetricsServer::kDefaultName = "doogie-metrics";
+
+QString MetricsServer::NameFromArgs(const QStringList& args) {
+  for (const auto& arg : args) {
+    if (arg == "--metrics-server") return kDefaultName;
+    if (arg.startsWith("--metrics-server=")) {
+      auto name = arg.mid(17);
+      return name.isEmpty() ? kDefaultName : name;
+    }
+  }
+  return QString();
+}
+
+MetricsServer::MetricsServer(const QString& name, QObject* parent)
+    : QObject(parent), server_(this) {
+  // Only the current user gets to read it
+  server_.setSocketOptions(QLocalServer::UserAccessOption);
+  // A crashed instance may have left the socket file behind
+  QLocalServer::removeServer(name);
+  if (!server_.listen(name)) {
+    qWarning() << "Unable to start metrics server on" << name << "-" <<
+                  server_.errorString();
+    return;
+  }
+  qInfo() << "Metrics server listening on" << server_.fullServerName();
+  connect(&server_, &QLocalServer::newConnection, this, [=]() {
+    while (server_.hasPendingConnections()) {
+      HandleConnection(server_.nextPendingConnection());
+    }
+  });
+}
+
+void MetricsServer::HandleConnection(QLocalSocket* socket) {
+  connect(socket, &QLocalSocket::disconnected,
+          socket, &QLocalSocket::deleteLater);
+  connect(socket, &QLocalSocket::readyRead, socket, [=]() {
+    while (socket->canReadLine()) {
+      auto command = QString::fromUtf8(socket->readLine()).trimmed();
+      if (command.isEmpty()) continue;
+      socket->write(QJsonDocument(Answer(command)).
+                    toJson(QJsonDocument::Compact));
+      socket->write("\n");
+    }
+  });
+}
+
+QJsonObject MetricsServer::Answer(const QString& command) const {
+  if (command == "metrics") return MetricsRegistry::Snapshot();
+  return { { "error", "Unrecognized command" } };
+}
+
+}  // namespace doogie
@@ -0,0 +1,34 @@
+#ifndef DOOGIE_METRICS_SERVER_H_
+#define DOOGIE_METRICS_SERVER_H_
+
+#include <QtNetwork>
+#include <QtWidgets>
+
+namespace doogie {
+
+// Local socket server that answers newline-terminated commands w/ a
+// single line of compact JSON. Only "metrics" is understood, it gives
+// the MetricsRegistry snapshot. It's off unless the app is started w/
+// --metrics-server or --metrics-server=<name> so soak tests can scrape it
+// from release builds.
+class MetricsServer : public QObject {
+  Q_OBJECT
+
+ public:
+  static const QString kDefaultName;
+
+  // Null if not asked for
+  static QString NameFromArgs(const QStringList& args);
+
+  explicit MetricsServer(const QString& name, QObject* parent = nullptr);
+
+ private:
+  void HandleConnection(QLocalSocket* socket);
+  QJsonObject Answer(const QString& command) const;
+
+  QLocalServer server_;
+};
+
+}  // namespace doogie
+
+#endif  // DOOGIE_METRICS_SERVER_H_
@@ -0,0 +1,24 @@
+-- Note, same format as schema.sql. This is run once on DBs at version 1.
+--
+-- Favicons are stored once per distinct image (looked up by a hash of the
+-- pixels, then compared) and referenced by ID from workspace and
+-- autocomplete pages.
+-- Existing autocomplete references are dropped, they come back on the
+-- next visit. Workspace page icon BLOBs are moved over lazily.
+DROP INDEX IF EXISTS favicon_url_hash_idx;
+
+DROP TABLE IF EXISTS favicon;
+
+CREATE TABLE favicon (
+  id INTEGER PRIMARY KEY AUTOINCREMENT NOT NULL,
+  hash INTEGER NOT NULL,
+  data BLOB NOT NULL
+);
+
+-- Not unique, different images can share a hash
+CREATE INDEX favicon_hash_idx ON favicon(hash);
+
+UPDATE autocomplete_page SET favicon_id = NULL;
+
+ALTER TABLE workspace_page
+  ADD COLUMN favicon_id INTEGER REFERENCES favicon(id);
@@ -0,0 +1,52 @@
+-- Note, same format as schema.sql. This is run once on DBs at version 2.
+--
+-- Expiration deletes by last visit, so it needs to be indexed.
+CREATE INDEX IF NOT EXISTS autocomplete_page_last_visited_idx
+  ON autocomplete_page(last_visited);
+
+-- Favicons know how many pages reference them so unused ones can be found
+-- w/out scanning every page.
+ALTER TABLE favicon ADD COLUMN ref_count INTEGER NOT NULL DEFAULT 0;
+
+UPDATE favicon SET ref_count = (
+  SELECT COUNT(1) FROM autocomplete_page WHERE favicon_id = favicon.id
+) + (
+  SELECT COUNT(1) FROM workspace_page WHERE favicon_id = favicon.id
+);
+
+CREATE INDEX IF NOT EXISTS favicon_unreferenced_idx
+  ON favicon(id) WHERE ref_count <= 0;
+
+CREATE TRIGGER IF NOT EXISTS favicon_ref_autocomplete_page_ai
+AFTER INSERT ON autocomplete_page WHEN new.favicon_id IS NOT NULL BEGIN
+  UPDATE favicon SET ref_count = ref_count + 1 WHERE id = new.favicon_id;
+END;
+
+CREATE TRIGGER IF NOT EXISTS favicon_ref_autocomplete_page_ad
+AFTER DELETE ON autocomplete_page WHEN old.favicon_id IS NOT NULL BEGIN
+  UPDATE favicon SET ref_count = ref_count - 1 WHERE id = old.favicon_id;
+END;
+
+CREATE TRIGGER IF NOT EXISTS favicon_ref_autocomplete_page_au
+AFTER UPDATE OF favicon_id ON autocomplete_page
+WHEN old.favicon_id IS NOT new.favicon_id BEGIN
+  UPDATE favicon SET ref_count = ref_count - 1 WHERE id = old.favicon_id;
+  UPDATE favicon SET ref_count = ref_count + 1 WHERE id = new.favicon_id;
+END;
+
+CREATE TRIGGER IF NOT EXISTS favicon_ref_workspace_page_ai
+AFTER INSERT ON workspace_page WHEN new.favicon_id IS NOT NULL BEGIN
+  UPDATE favicon SET ref_count = ref_count + 1 WHERE id = new.favicon_id;
+END;
+
+CREATE TRIGGER IF NOT EXISTS favicon_ref_workspace_page_ad
+AFTER DELETE ON workspace_page WHEN old.favicon_id IS NOT NULL BEGIN
+  UPDATE favicon SET ref_count = ref_count - 1 WHERE id = old.favicon_id;
+END;
+
+CREATE TRIGGER IF NOT EXISTS favicon_ref_workspace_page_au
+AFTER UPDATE OF favicon_id ON workspace_page
+WHEN old.favicon_id IS NOT new.favicon_id BEGIN
+  UPDATE favicon SET ref_count = ref_count - 1 WHERE id = old.favicon_id;
+  UPDATE favicon SET ref_count = ref_count + 1 WHERE id = new.favicon_id;
+END;
@@ -0,0 +1,57 @@
+-- Note, same format as schema.sql. This is run once on DBs at version 3.
+--
+-- Frecency is now a decayed score: every visit adds 2^((t - epoch) / h)
+-- where t is the visit time, epoch is 2018-01-01 UTC and h is the 30 day
+-- half-life. Scaling all scores by the same decay doesn't change their
+-- order, so the sum is just added to on each visit and never recomputed.
+-- SQLite has no pow, so existing scores are seeded from
+-- PageIndex::SeedFrecency right after this runs, in the same transaction.
+--
+-- The FTS table has to be recreated to get prefix indexes. Short prefixes
+-- are the most common thing typed and w/out these each one has to merge
+-- the doclists of every term that starts with it.
+DROP TRIGGER IF EXISTS autocomplete_page_trig_ai;
+
+DROP TRIGGER IF EXISTS autocomplete_page_trig_ad;
+
+DROP TRIGGER IF EXISTS autocomplete_page_trig_au;
+
+DROP TABLE IF EXISTS autocomplete_page_fts;
+
+CREATE VIRTUAL TABLE IF NOT EXISTS autocomplete_page_fts USING FTS5(
+  schemeless_url,
+  title,
+  frecency UNINDEXED,
+  content=autocomplete_page,
+  content_rowid=id,
+  -- Make _, -, and ' as part of the token
+  tokenize = "unicode61 tokenchars '-_'",
+  prefix = '1 2 3'
+);
+
+-- The default rank, URL matches are worth twice title ones
+INSERT INTO autocomplete_page_fts(autocomplete_page_fts, rank)
+  VALUES ('rank', 'bm25(2.0, 1.0)');
+
+INSERT INTO autocomplete_page_fts(autocomplete_page_fts)
+  VALUES ('rebuild');
+
+CREATE TRIGGER IF NOT EXISTS autocomplete_page_trig_ai
+AFTER INSERT ON autocomplete_page BEGIN
+  INSERT INTO autocomplete_page_fts(rowid, schemeless_url, title, frecency)
+    VALUES (new.id, new.schemeless_url, new.title, new.frecency);
+END;
+
+CREATE TRIGGER IF NOT EXISTS autocomplete_page_trig_ad
+AFTER DELETE ON autocomplete_page BEGIN
+  INSERT INTO autocomplete_page_fts(autocomplete_page_fts, rowid, schemeless_url, title, frecency)
+    VALUES ('delete', old.id, old.schemeless_url, old.title, old.frecency);
+END;
+
+CREATE TRIGGER IF NOT EXISTS autocomplete_page_trig_au
+AFTER UPDATE ON autocomplete_page BEGIN
+  INSERT INTO autocomplete_page_fts(autocomplete_page_fts, rowid, schemeless_url, title, frecency)
+    VALUES ('delete', old.id, old.schemeless_url, old.title, old.frecency);
+  INSERT INTO autocomplete_page_fts(rowid, schemeless_url, title, frecency)
+    VALUES (new.id, new.schemeless_url, new.title, new.frecency);
+END;
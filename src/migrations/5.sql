@@ -0,0 +1,25 @@
+-- Note, same format as schema.sql. This is run once on DBs at version 4.
+--
+-- Visits are upserted by URL, so it has to be unique. It always should
+-- have been, but just in case, only keep the latest of any dupes.
+DELETE FROM autocomplete_page WHERE id NOT IN (
+  SELECT MAX(id) FROM autocomplete_page GROUP BY url
+);
+
+CREATE UNIQUE INDEX IF NOT EXISTS autocomplete_page_url_idx
+  ON autocomplete_page(url);
+
+-- Most updates are visits that only touch the counts and frecency, which
+-- the FTS table doesn't index (the UNINDEXED frecency is read from the
+-- content table anyways). So only redo the FTS row when the text changes.
+DROP TRIGGER IF EXISTS autocomplete_page_trig_au;
+
+CREATE TRIGGER IF NOT EXISTS autocomplete_page_trig_au
+AFTER UPDATE OF schemeless_url, title ON autocomplete_page
+WHEN old.schemeless_url IS NOT new.schemeless_url OR
+     old.title IS NOT new.title BEGIN
+  INSERT INTO autocomplete_page_fts(autocomplete_page_fts, rowid, schemeless_url, title, frecency)
+    VALUES ('delete', old.id, old.schemeless_url, old.title, old.frecency);
+  INSERT INTO autocomplete_page_fts(rowid, schemeless_url, title, frecency)
+    VALUES (new.id, new.schemeless_url, new.title, new.frecency);
+END;
@@ -1,18 +1,100 @@
 #include "page_index.h"
 
+#include <cmath>
+
+#include "favicon_store.h"
+#include "metrics_registry.h"
 #include "sql.h"
+#include "sql_executor.h"
+#include "tracing.h"
 #include "util.h"
 
 namespace doogie {
 
+PageIndex::Suggester* PageIndex::suggester_ = nullptr;
+FrecencyIndex* PageIndex::frecency_index_ = nullptr;
+QMutex PageIndex::metrics_mutex_;
+PageIndex::ExpirationMetrics PageIndex::metrics_;
+QHash<QString, PageIndex::PendingVisit> PageIndex::pending_visits_;
+QTimer* PageIndex::pending_visits_timer_ = nullptr;
+
 PageIndex::Expirer::Expirer() {
   timer.connect(&timer, &QTimer::timeout, PageIndex::DoExpiration);
   // 3 minutes for now
   timer.start(3 * 60 * 1000);
 }
 
-QList<PageIndex::AutocompletePage> PageIndex::AutocompleteSuggest(
-    const QString& text, int count) {
+void PageIndex::LoadFrecencyIndex() {
+  auto capacity = QSettings().value(
+        "pageIndex/frecencyIndexSize", kDefaultFrecencyIndexSize).toInt();
+  SqlExecutor::Enqueue([=](QSqlQuery* query) -> QVariant {
+    Tracing::Span span("pageIndex", "LoadFrecencyIndex");
+    auto ok = Sql::ExecParam(
+          query,
+          "SELECT id, url, title, favicon_id, frecency, last_visited "
+          "FROM autocomplete_page "
+          "ORDER BY frecency DESC "
+          "LIMIT ?",
+          { capacity });
+    if (!ok) return QVariant();
+    QList<FrecencyIndex::Entry> entries;
+    while (query->next()) entries.append(IndexEntry(query->record()));
+    Util::RunOnMainThread([=]() {
+      delete frecency_index_;
+      frecency_index_ = new FrecencyIndex(capacity);
+      for (const auto& entry : entries) frecency_index_->Upsert(entry);
+      frecency_index_->SetComplete(entries.size() < capacity);
+    });
+    return true;
+  });
+}
+
+std::function<void()> PageIndex::AutocompleteSuggest(
+    const QString& text,
+    int count,
+    std::function<void(QList<AutocompletePage>)> callback) {
+  static auto index_hits =
+      MetricsRegistry::GetCounter("pageIndex.suggest.indexHits");
+  static auto db_queries =
+      MetricsRegistry::GetCounter("pageIndex.suggest.dbQueries");
+  Tracing::Span span("pageIndex", "AutocompleteSuggest", text);
+  QList<FrecencyIndex::Entry> entries;
+  if (frecency_index_ && frecency_index_->Find(text, count, &entries)) {
+    index_hits->Increment();
+    QList<AutocompletePage> pages;
+    for (const auto& entry : entries) {
+      pages.append(AutocompletePage {
+          entry.url, entry.title, entry.favicon_id
+      });
+    }
+    callback(pages);
+    return []() { };
+  }
+  db_queries->Increment();
+  auto db_name = QSqlDatabase::database().databaseName();
+  // Nothing to share an in-mem DB with, so we just run it here
+  if (db_name == ":memory:") {
+    QSqlQuery query;
+    callback(QuerySuggestions(&query, text, count));
+    return []() { };
+  }
+  if (!suggester_) {
+    suggester_ = new Suggester(db_name);
+    QObject::connect(QCoreApplication::instance(),
+                     &QCoreApplication::aboutToQuit, []() {
+      delete suggester_;
+      suggester_ = nullptr;
+    });
+    suggester_->start();
+  }
+  auto generation = suggester_->Submit({ text, count, callback, 0 });
+  return [=]() {
+    if (suggester_) suggester_->Cancel(generation);
+  };
+}
+
+QList<PageIndex::AutocompletePage> PageIndex::QuerySuggestions(
+    QSqlQuery* query, const QString& text, int count) {
   // Take the text, trim, split on space, ignore empties, add asterisk
   // after each item, rejoin, search...
   // Oh, and we quote it, which means replace existing quotes w/ double quotes
@@ -29,156 +111,336 @@ QList<PageIndex::AutocompletePage> PageIndex::AutocompleteSuggest(
   }
   QList<PageIndex::AutocompletePage> ret;
   if (to_search.length() == 1) return ret;
-  QSqlQuery query;
+  static auto query_time =
+      MetricsRegistry::GetHistogram("pageIndex.suggest.query");
+  MetricsRegistry::ScopedTimer timer(query_time);
+  Tracing::Span span("pageIndex", "QuerySuggestions", text);
+  // The rank is bm25 as configured on the FTS table (it's negative, lower
+  // is better). Only the top rows are joined, and SQLite only keeps the
+  // top LIMIT while scanning instead of sorting every match.
   auto sql = QString(
-      "SELECT ap.url, ap.title, f.url as favicon_url "
-      "FROM autocomplete_page_fts('%1') apf "
+      "SELECT ap.url, ap.title, ap.favicon_id "
+      "FROM ( "
+      "  SELECT rowid, frecency * (1.0 - rank * %3) AS score "
+      "  FROM autocomplete_page_fts('%1') "
+      "  ORDER BY score DESC "
+      "  LIMIT %2 "
+      ") apf "
       "  JOIN autocomplete_page ap ON "
       "    ap.id = apf.rowid "
-      "  LEFT JOIN favicon f "
-      "    ON f.id = ap.favicon_id "
-      "ORDER BY apf.frecency DESC "
-      "LIMIT %2").arg(to_search).arg(count);
-  if (!Sql::Exec(&query, sql)) return ret;
-  while (query.next()) {
+      "ORDER BY apf.score DESC").
+      arg(to_search, QString::number(count),
+          QString::number(kRankBm25Weight));
+  if (!Sql::Exec(query, sql)) return ret;
+  while (query->next()) {
     ret.append(PageIndex::AutocompletePage {
-        query.value("url").toString(),
-        query.value("title").toString(),
-        CachedFavicon(query.value("favicon_url").toString())
+        query->value("url").toString(),
+        query->value("title").toString(),
+        query->value("favicon_id")
     });
   }
   return ret;
 }
 
+PageIndex::Suggester::Suggester(const QString& db_name)
+    : db_name_(db_name) { }
+
+PageIndex::Suggester::~Suggester() {
+  {
+    QMutexLocker locker(&mutex_);
+    stopping_ = true;
+    has_request_.wakeAll();
+  }
+  wait();
+}
+
+int PageIndex::Suggester::Submit(Request request) {
+  QMutexLocker locker(&mutex_);
+  // Anything not yet started is just replaced
+  request.generation = generation_.fetchAndAddOrdered(1) + 1;
+  request_ = request;
+  request_pending_ = true;
+  has_request_.wakeAll();
+  return request.generation;
+}
+
+void PageIndex::Suggester::Cancel(int generation) {
+  generation_.testAndSetOrdered(generation, generation + 1);
+}
+
+void PageIndex::Suggester::run() {
+  {
+    auto db = QSqlDatabase::addDatabase("QSQLITE", "doogie_suggester");
+    db.setDatabaseName(db_name_);
+    if (!db.open()) {
+      qCritical() << "Unable to open suggestion connection: " <<
+                     db.lastError().text();
+    }
+    QSqlQuery query(db);
+    forever {
+      Request request;
+      {
+        QMutexLocker locker(&mutex_);
+        while (!request_pending_ && !stopping_) has_request_.wait(&mutex_);
+        if (stopping_) break;
+        request = request_;
+        request_pending_ = false;
+      }
+      // We can't interrupt a running query, but we can make sure a
+      //  superseded one is never delivered
+      if (request.generation != generation_.loadAcquire()) continue;
+      auto pages = QuerySuggestions(&query, request.text, request.count);
+      query.finish();
+      if (request.generation != generation_.loadAcquire()) continue;
+      auto gen = request.generation;
+      auto callback = request.callback;
+      Util::RunOnMainThread([=]() {
+        if (suggester_ && suggester_->generation_.loadAcquire() == gen) {
+          callback(pages);
+        }
+      });
+    }
+  }
+  QSqlDatabase::removeDatabase("doogie_suggester");
+}
+
 bool PageIndex::MarkVisit(const QString& url,
                           const QString& title,
-                          const QString& favicon_url,
                           const QIcon& favicon) {
-  // We are doing this by URL hash and then URL (for collisions).
-  // We don't expect *that* much contention so we'll do an update
-  // and if 0 affected, then insert. Since we don't put the URL
-  // itself into a unique index, we cannot use insert-or-replace.
-  // We accept the obvious race condition that exists here and
-  // trust the caller only does this in one thread.
-  auto scheme_sep = url.indexOf("://");
-  if (scheme_sep == -1) return false;
-  auto hash = Util::HashString(url);
-  auto schemeless_url = url.mid(scheme_sep + 3);
+  if (url.indexOf("://") == -1) return false;
+  // Visits come in bursts (e.g. restoring a workspace), so they are held
+  // and written together. Repeat visits to the same URL just add up.
   auto curr_secs = QDateTime::currentSecsSinceEpoch();
-  auto favicon_id = FaviconId(favicon_url, favicon);
-  QSqlQuery query;
-  auto ok = Sql::ExecParam(
-      &query,
-      "UPDATE autocomplete_page SET "
-      "  schemeless_url = ?, "
-      "  title = ?, "
-      "  favicon_id = ?, "
-      "  last_visited = ?, "
-      "  visit_count = visit_count + 1, "
-      "  frecency = ? + ((visit_count + 1) * ?) "
-      "WHERE url_hash = ? AND url = ? ",
-      { schemeless_url, title, favicon_id, curr_secs,
-        curr_secs, kVisitTimeWorthSeconds, hash, url });
-  if (!ok) return false;
-  if (query.numRowsAffected() > 0) return true;
-  // Try an insert
-  return Sql::ExecParam(
-    &query,
-    "INSERT INTO autocomplete_page ( "
-    "  url, url_hash, schemeless_url, title, "
-    "  favicon_id, last_visited, visit_count, frecency "
-    ") VALUES (?, ?, ?, ?, ?, ?, ?, ?) ",
-    { url, hash, schemeless_url, title, favicon_id,
-      curr_secs, 1, curr_secs + kVisitTimeWorthSeconds });
+  auto& visit = pending_visits_[url];
+  visit.title = title;
+  // Pixmaps can't leave the GUI thread, images can
+  visit.favicon = FaviconStore::ImageFromIcon(favicon);
+  visit.last_visited = curr_secs;
+  visit.visit_count++;
+  visit.frecency += VisitFrecency(curr_secs);
+  if (!pending_visits_timer_) {
+    pending_visits_timer_ = new QTimer;
+    pending_visits_timer_->setSingleShot(true);
+    pending_visits_timer_->setInterval(kVisitDebounceMs);
+    QObject::connect(pending_visits_timer_, &QTimer::timeout,
+                     &PageIndex::FlushPendingVisits);
+  }
+  if (!pending_visits_timer_->isActive()) pending_visits_timer_->start();
+  return true;
+}
+
+void PageIndex::FlushPendingVisits() {
+  if (pending_visits_timer_) pending_visits_timer_->stop();
+  if (pending_visits_.isEmpty()) return;
+  auto visits = pending_visits_;
+  pending_visits_.clear();
+  static auto flushed = MetricsRegistry::GetCounter("pageIndex.visitsFlushed");
+  flushed->Increment(visits.size());
+  // The writer runs this in a single transaction
+  SqlExecutor::Enqueue([visits](QSqlQuery* query) -> QVariant {
+    Tracing::Span span("pageIndex", "FlushPendingVisits",
+                       QString("%1 visits").arg(visits.size()));
+    // Everything we need to resolve first, so the writes can stay prepared
+    QHash<QString, QVariant> favicon_ids;
+    for (auto it = visits.constBegin(); it != visits.constEnd(); it++) {
+      favicon_ids[it.key()] = FaviconStore::Id(query, it->favicon);
+    }
+    // The URL is unique, so new ones are inserted empty, then all of them
+    // get the visits added. Not an upsert, which needs SQLite 3.24 and Qt
+    // may be linked to an older one. The schemeless URL comes from the URL
+    // so it never changes.
+    if (!Sql::Prepare(
+          query,
+          "INSERT OR IGNORE INTO autocomplete_page ( "
+          "  url, url_hash, schemeless_url, title, "
+          "  favicon_id, last_visited, visit_count, frecency "
+          ") VALUES (?, ?, ?, ?, ?, ?, 0, 0)")) {
+      return QVariant();
+    }
+    auto ok = true;
+    for (auto it = visits.constBegin(); it != visits.constEnd(); it++) {
+      const auto& url = it.key();
+      query->addBindValue(url);
+      query->addBindValue(Util::HashString(url));
+      query->addBindValue(url.mid(url.indexOf("://") + 3));
+      query->addBindValue(it->title);
+      query->addBindValue(favicon_ids[url]);
+      query->addBindValue(it->last_visited);
+      ok = Sql::Exec(query) && ok;
+    }
+    if (!Sql::Prepare(
+          query,
+          "UPDATE autocomplete_page SET "
+          "  title = ?, "
+          "  favicon_id = ?, "
+          "  last_visited = ?, "
+          "  visit_count = visit_count + ?, "
+          "  frecency = frecency + ? "
+          "WHERE url = ?")) {
+      return QVariant();
+    }
+    for (auto it = visits.constBegin(); it != visits.constEnd(); it++) {
+      query->addBindValue(it->title);
+      query->addBindValue(favicon_ids[it.key()]);
+      query->addBindValue(it->last_visited);
+      query->addBindValue(it->visit_count);
+      query->addBindValue(it->frecency);
+      query->addBindValue(it.key());
+      ok = Sql::Exec(query) && ok;
+    }
+    // Keep the in-memory index up to date
+    QList<FrecencyIndex::Entry> entries;
+    if (Sql::Prepare(
+          query,
+          "SELECT id, url, title, favicon_id, frecency, last_visited "
+          "FROM autocomplete_page "
+          "WHERE url = ?")) {
+      for (auto it = visits.constBegin(); it != visits.constEnd(); it++) {
+        query->addBindValue(it.key());
+        if (Sql::Exec(query) && query->next()) {
+          entries.append(IndexEntry(query->record()));
+        }
+      }
+    }
+    Util::RunOnMainThread([=]() {
+      if (!frecency_index_) return;
+      for (const auto& entry : entries) frecency_index_->Upsert(entry);
+    });
+    return ok ? QVariant(true) : QVariant();
+  });
 }
 
 bool PageIndex::UpdateTitle(const QString& url, const QString& title) {
-  QSqlQuery query;
-  return Sql::ExecParam(
-      &query,
+  if (frecency_index_) frecency_index_->UpdateTitle(url, title);
+  // Not written yet, so we can just change what will be
+  auto visit = pending_visits_.find(url);
+  if (visit != pending_visits_.end()) {
+    visit->title = title;
+    return true;
+  }
+  SqlExecutor::EnqueueParam(
       "UPDATE autocomplete_page SET title = ? "
       "WHERE url_hash = ? and url = ?",
       { title, Util::HashString(url), url });
+  return true;
 }
 
 bool PageIndex::UpdateFavicon(const QString& url,
-                              const QString& favicon_url,
                               const QIcon& favicon) {
-  QSqlQuery query;
-  return Sql::ExecParam(
-      &query,
-      "UPDATE autocomplete_page SET favicon_id = ? "
-      "WHERE url_hash = ? AND url = ?",
-      { FaviconId(favicon_url, favicon), Util::HashString(url), url });
-}
-
-QIcon PageIndex::CachedFavicon(const QString& url) {
-  if (url.isEmpty()) return QIcon();
-  // We'll just use the pixmap cache directly here
-  QPixmap pixmap;
-  auto key = QString("doogie:favicon_") + url;
-  if (!QPixmapCache::find(key, &pixmap)) {
-    QSqlQuery query;
-    auto hash = Util::HashString(url);
-    auto rec = Sql::ExecSingleParam(
-          &query,
-          "SELECT data FROM favicon "
-          "WHERE url_hash = ? AND url = ?",
-          { hash, url });
-    if (rec.isEmpty()) return QIcon();
-    pixmap.loadFromData(rec.value(0).toByteArray(), "PNG");
-    QPixmapCache::insert(key, pixmap);
+  auto favicon_image = FaviconStore::ImageFromIcon(favicon);
+  auto visit = pending_visits_.find(url);
+  if (visit != pending_visits_.end()) {
+    visit->favicon = favicon_image;
+    return true;
   }
-  return QIcon(pixmap);
+  SqlExecutor::Enqueue([=](QSqlQuery* query) -> QVariant {
+    auto favicon_id = FaviconStore::Id(query, favicon_image);
+    auto ok = Sql::ExecParam(
+        query,
+        "UPDATE autocomplete_page SET favicon_id = ? "
+        "WHERE url_hash = ? AND url = ?",
+        { favicon_id, Util::HashString(url), url });
+    if (!ok) return QVariant();
+    Util::RunOnMainThread([=]() {
+      if (frecency_index_) frecency_index_->UpdateFavicon(url, favicon_id);
+    });
+    return true;
+  });
+  return true;
+}
+
+double PageIndex::VisitFrecency(qlonglong secs) {
+  // Doubles are good until ~1000 half-lives past the epoch, i.e. 2100
+  return std::pow(2.0, static_cast<double>(secs - kFrecencyEpochSeconds) /
+                  kFrecencyHalfLifeSeconds);
+}
+
+bool PageIndex::SeedFrecency(QSqlQuery* query) {
+  if (!Sql::Exec(query, "SELECT id, visit_count, last_visited "
+                        "FROM autocomplete_page")) {
+    return false;
+  }
+  QList<QPair<qlonglong, double>> seeds;
+  while (query->next()) {
+    seeds.append(qMakePair(
+        query->value(0).toLongLong(),
+        query->value(1).toLongLong() *
+            VisitFrecency(query->value(2).toLongLong())));
+  }
+  if (!Sql::Prepare(query, "UPDATE autocomplete_page "
+                           "SET frecency = ? WHERE id = ?")) {
+    return false;
+  }
+  for (const auto& seed : seeds) {
+    query->addBindValue(seed.second);
+    query->addBindValue(seed.first);
+    if (!Sql::Exec(query)) return false;
+  }
+  return true;
+}
+
+PageIndex::ExpirationMetrics PageIndex::Metrics() {
+  QMutexLocker locker(&metrics_mutex_);
+  return metrics_;
 }
 
 void PageIndex::DoExpiration() {
-  QSqlQuery query;
   auto old =
       QDateTime::currentSecsSinceEpoch() - kExpireNotVisitedSinceSeconds;
-  Sql::ExecParam(
-        &query,
-        "DELETE FROM autocomplete_page WHERE last_visited < ?",
-        { old });
-  Sql::Exec(
-        &query,
-        // Meh, we know it's slow...put it in the delete trigger instead?
-        "DELETE FROM favicon WHERE id NOT IN ( "
-        "  SELECT DISTINCT favicon_id "
-        "  FROM autocomplete_page "
-        ")");
-}
-
-QVariant PageIndex::FaviconId(const QString& url, const QIcon& favicon) {
-  if (url.isEmpty() || favicon.isNull()) return QVariant(QVariant::LongLong);
-  auto hash = Util::HashString(url);
-  QSqlQuery query;
-  auto icon_bytes = [=]() -> QByteArray {
-    QBuffer buffer;
-    buffer.open(QIODevice::WriteOnly);
-    favicon.pixmap(16, 16).save(&buffer, "PNG");
-    return buffer.data();
-  };
-  auto record = Sql::ExecSingleParam(
-      &query,
-      "SELECT id "
-      "FROM favicon "
-      "WHERE url_hash = ? AND url = ?",
-      { hash, url });
-  if (query.lastError().isValid()) return QVariant(QVariant::LongLong);
-  if (!record.isEmpty()) return record.value("id");
-  // Not there, insert
-  QBuffer buffer;
-  buffer.open(QIODevice::WriteOnly);
-  favicon.pixmap(16, 16).save(&buffer, "PNG");
-  auto ok = Sql::ExecParam(
-      &query,
-      "INSERT INTO favicon ( "
-      "  url, url_hash, data "
-      ") VALUES (?, ?, ?)",
-      { url, hash, buffer.data() });
-  if (!ok) return QVariant(QVariant::LongLong);
-  return query.lastInsertId();
+  if (frecency_index_) frecency_index_->RemoveVisitedBefore(old);
+  ExpireBatch(old, ExpirationMetrics());
+}
+
+void PageIndex::ExpireBatch(qlonglong visited_before,
+                            ExpirationMetrics run_so_far) {
+  SqlExecutor::Enqueue([=](QSqlQuery* query) -> QVariant {
+    QElapsedTimer timer;
+    timer.start();
+    auto run = run_so_far;
+    auto pages = -1;
+    auto ok = Sql::ExecParam(
+          query,
+          "DELETE FROM autocomplete_page WHERE id IN ( "
+          "  SELECT id FROM autocomplete_page "
+          "  WHERE last_visited < ? "
+          "  LIMIT ? "
+          ")",
+          { visited_before, kExpireBatchSize });
+    if (ok) pages = query->numRowsAffected();
+    // Page deletes lower the ref counts, so only do favicons after them
+    auto favicons = 0;
+    if (pages >= 0 && pages < kExpireBatchSize) {
+      favicons = FaviconStore::DeleteUnused(query, kExpireBatchSize);
+    }
+    run.pages_expired += qMax(pages, 0);
+    run.favicons_deleted += qMax(favicons, 0);
+    run.msecs_spent += timer.elapsed();
+    if (pages == kExpireBatchSize || favicons == kExpireBatchSize) {
+      // Queued behind whatever else is waiting to be written
+      ExpireBatch(visited_before, run);
+    } else {
+      qDebug() << "Page index expiration removed" << run.pages_expired <<
+                  "pages and" << run.favicons_deleted << "favicons in" <<
+                  run.msecs_spent << "ms";
+      QMutexLocker locker(&metrics_mutex_);
+      metrics_.runs++;
+      metrics_.pages_expired += run.pages_expired;
+      metrics_.favicons_deleted += run.favicons_deleted;
+      metrics_.msecs_spent += run.msecs_spent;
+    }
+    return pages >= 0 && favicons >= 0 ? QVariant(true) : QVariant();
+  });
+}
+
+FrecencyIndex::Entry PageIndex::IndexEntry(const QSqlRecord& record) {
+  FrecencyIndex::Entry entry;
+  entry.id = record.value("id").toLongLong();
+  entry.url = record.value("url").toString();
+  entry.title = record.value("title").toString();
+  entry.favicon_id = record.value("favicon_id");
+  entry.frecency = record.value("frecency").toDouble();
+  entry.last_visited = record.value("last_visited").toLongLong();
+  return entry;
 }
 
 }  // namespace doogie
@@ -4,6 +4,8 @@
 #include <QtSql>
 #include <QtWidgets>
 
+#include "frecency_index.h"
+
 namespace doogie {
 
 // Utility/helper class for doing page index lookups for things like
@@ -17,35 +19,128 @@ class PageIndex {
     QTimer timer;
   };
 
+  struct ExpirationMetrics {
+    qlonglong runs = 0;
+    qlonglong pages_expired = 0;
+    qlonglong favicons_deleted = 0;
+    // Only time spent on the writer, not time waiting between batches
+    qlonglong msecs_spent = 0;
+  };
+
   struct AutocompletePage {
     QString url;
     QString title;
-    QIcon favicon;
+    // Give to FaviconStore::Icon, left for the caller so it can load them
+    //  after showing the rest
+    QVariant favicon_id;
   };
 
   // Just make it 90 days for now
   static const qlonglong kExpireNotVisitedSinceSeconds = 90ll * 24 * 60 * 60;
-  // Amount of time a visit is worth for frecency...for now it's a day
-  static const qlonglong kVisitTimeWorthSeconds = 24ll * 60 * 60;
+  // Expiration deletes at most this many rows per writer transaction
+  static const int kExpireBatchSize = 500;
+  // Frecency is the sum of 2^((visit - epoch) / half-life) over all
+  //  visits, see migrations/4.sql. Decaying every score the same way
+  //  doesn't change their order, so it's only ever added to.
+  static const qlonglong kFrecencyEpochSeconds = 1514764800ll;
+  static const qlonglong kFrecencyHalfLifeSeconds = 30ll * 24 * 60 * 60;
+  // Each point of bm25 from the DB suggestions boosts frecency this much
+  static constexpr double kRankBm25Weight = 0.1;
+  // How many of the most frecent pages are kept in memory by default,
+  //  overridable w/ the pageIndex/frecencyIndexSize setting
+  static const int kDefaultFrecencyIndexSize = 5000;
+
+  // Visits are written this long after the first unwritten one
+  static const int kVisitDebounceMs = 300;
 
-  static QList<AutocompletePage> AutocompleteSuggest(const QString& text,
-                                                     int count);
+  // Loads the most frecent pages so most suggestions never hit the DB
+  static void LoadFrecencyIndex();
+
+  // This is answered from the in-memory index when it can be, in which
+  //  case the callback is invoked before returning. Otherwise it is run on
+  //  a background connection and the callback is invoked on the GUI
+  //  thread. Each call supersedes the previous one, so only the callback
+  //  for the latest is invoked. The result cancels the request.
+  static std::function<void()> AutocompleteSuggest(
+      const QString& text,
+      int count,
+      std::function<void(QList<AutocompletePage>)> callback);
 
   static bool MarkVisit(const QString& url,
                         const QString& title,
-                        const QString& favicon_url,
                         const QIcon& favicon);
+  // Writes all held visits now instead of waiting for the debounce
+  static void FlushPendingVisits();
   static bool UpdateTitle(const QString& url, const QString& title);
   static bool UpdateFavicon(const QString& url,
-                            const QString& favicon_url,
                             const QIcon& favicon);
 
-  static QIcon CachedFavicon(const QString& url);
+  // Totals across all expiration runs so far
+  static ExpirationMetrics Metrics();
+
+  // Sets every page's frecency as if all its visits were the last one.
+  //  Given to Sql::EnsureDatabaseSchema for the migration that added
+  //  decayed frecency, since SQLite has no pow to do it in the script.
+  static bool SeedFrecency(QSqlQuery* query);
 
  private:
+  // Runs the latest suggestion request on its own connection
+  class Suggester : public QThread {
+   public:
+    struct Request {
+      QString text;
+      int count = 0;
+      std::function<void(QList<AutocompletePage>)> callback;
+      int generation = 0;
+    };
+
+    explicit Suggester(const QString& db_name);
+    ~Suggester();
+    // Returns the generation
+    int Submit(Request request);
+    void Cancel(int generation);
+
+   protected:
+    void run() override;
+
+   private:
+    QString db_name_;
+    QMutex mutex_;
+    QWaitCondition has_request_;
+    Request request_;
+    bool request_pending_ = false;
+    bool stopping_ = false;
+    QAtomicInt generation_;
+  };
+
+  // All visits to a URL since the last write, summed
+  struct PendingVisit {
+    QString title;
+    QImage favicon;
+    qlonglong last_visited = 0;
+    int visit_count = 0;
+    double frecency = 0;
+  };
+
+  static QList<AutocompletePage> QuerySuggestions(QSqlQuery* query,
+                                                  const QString& text,
+                                                  int count);
+  // What a visit at the given time adds to the frecency
+  static double VisitFrecency(qlonglong secs);
   static void DoExpiration();
+  // Runs one batch on the writer and queues the next if there is more
+  static void ExpireBatch(qlonglong visited_before,
+                          ExpirationMetrics run_so_far);
+  static FrecencyIndex::Entry IndexEntry(const QSqlRecord& record);
 
-  static QVariant FaviconId(const QString& url, const QIcon& favicon);
+  static Suggester* suggester_;
+  // Only touched on the GUI thread
+  static FrecencyIndex* frecency_index_;
+  // Keyed by URL, only touched on the GUI thread
+  static QHash<QString, PendingVisit> pending_visits_;
+  static QTimer* pending_visits_timer_;
+  static QMutex metrics_mutex_;
+  static ExpirationMetrics metrics_;
 };
 
 }  // namespace doogie
@@ -0,0 +1,117 @@
+#include "page_load_scheduler.h"
+
+#include "metrics_registry.h"
+#include "page_tree.h"
+
+namespace doogie {
+
+PageLoadScheduler::PageLoadScheduler(PageTree* tree)
+    : QObject(tree), tree_(tree) {
+  max_concurrent_ = qMax(1, QSettings().value(
+      "pageLoad/maxConcurrent", kDefaultMaxConcurrentLoads).toInt());
+  connect(tree, &PageTree::ItemDestroyed, this, &PageLoadScheduler::Remove);
+  // What's visible may have changed
+  connect(tree->verticalScrollBar(), &QScrollBar::valueChanged,
+          this, &PageLoadScheduler::ScheduleAdmit);
+  QPointer<PageLoadScheduler> self(this);
+  MetricsRegistry::SetGaugeCallback("pageTree.loadQueueDepth", [self]() {
+    return self ? self->QueueDepth() : 0;
+  });
+  MetricsRegistry::SetGaugeCallback("pageTree.activeLoads", [self]() {
+    return self ? self->ActiveLoads() : 0;
+  });
+}
+
+void PageLoadScheduler::Enqueue(PageTreeItem* item) {
+  if (pending_.contains(item)) return;
+  pending_.insert(item);
+  order_.append(item);
+  emit QueueDepthChanged(pending_.size());
+  ScheduleAdmit();
+}
+
+void PageLoadScheduler::Remove(PageTreeItem* item) {
+  if (!pending_.remove(item)) return;
+  order_.removeOne(item);
+  emit QueueDepthChanged(pending_.size());
+}
+
+void PageLoadScheduler::TrackLoad(BrowserWidget* browser) {
+  if (active_.contains(browser)) return;
+  active_.insert(browser);
+  connect(browser, &BrowserWidget::LoadingStateChanged, this, [=]() {
+    if (!browser->Loading()) LoadDone(browser);
+  });
+  connect(browser, &QObject::destroyed, this, [=]() { LoadDone(browser); });
+  QPointer<BrowserWidget> guarded(browser);
+  QTimer::singleShot(kLoadTimeoutMs, this, [=]() {
+    // Already handled when destroyed
+    if (guarded) LoadDone(guarded);
+  });
+}
+
+void PageLoadScheduler::ScheduleAdmit() {
+  if (admit_scheduled_ || pending_.isEmpty()) return;
+  admit_scheduled_ = true;
+  QTimer::singleShot(0, this, [=]() {
+    admit_scheduled_ = false;
+    Admit();
+  });
+}
+
+void PageLoadScheduler::Admit() {
+  if (active_.size() >= max_concurrent_ || pending_.isEmpty()) return;
+  // Visible first, otherwise the first in the tree
+  auto visible = VisiblePending();
+  while (active_.size() < max_concurrent_ && !pending_.isEmpty()) {
+    PageTreeItem* item = nullptr;
+    if (!visible.isEmpty()) {
+      item = visible.takeFirst();
+    } else {
+      while (!order_.isEmpty() && !pending_.contains(order_.first())) {
+        order_.removeFirst();
+      }
+      if (order_.isEmpty()) break;
+      item = order_.takeFirst();
+    }
+    pending_.remove(item);
+    emit QueueDepthChanged(pending_.size());
+    // This calls back into TrackLoad
+    tree_->MaterializeItem(item);
+  }
+  // Drop the skipped ones
+  if (pending_.isEmpty()) order_.clear();
+}
+
+QList<PageTreeItem*> PageLoadScheduler::VisiblePending() const {
+  // Only walks from the top row to the bottom one instead of the whole tree
+  QList<PageTreeItem*> ret;
+  auto viewport = tree_->viewport()->rect();
+  auto top = tree_->itemAt(viewport.topLeft());
+  if (!top) return ret;
+  // Null when the tree ends above the bottom, so we go to the end
+  auto bottom = tree_->itemAt(viewport.bottomLeft());
+  QTreeWidgetItemIterator it(top);
+  while (*it) {
+    if ((*it)->type() == PageTree::kPageItemType) {
+      auto item = static_cast<PageTreeItem*>(*it);
+      // Collapsed ones in the range have no rect
+      if (pending_.contains(item) &&
+          !tree_->visualItemRect(item).isEmpty()) {
+        ret.append(item);
+      }
+    }
+    if (*it == bottom) break;
+    it++;
+  }
+  return ret;
+}
+
+void PageLoadScheduler::LoadDone(BrowserWidget* browser) {
+  if (!active_.remove(browser)) return;
+  // Don't need to hear from it again
+  disconnect(browser, nullptr, this, nullptr);
+  ScheduleAdmit();
+}
+
+}  // namespace doogie
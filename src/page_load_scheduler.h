@@ -0,0 +1,60 @@
+#ifndef DOOGIE_PAGE_LOAD_SCHEDULER_H_
+#define DOOGIE_PAGE_LOAD_SCHEDULER_H_
+
+#include <QtWidgets>
+
+#include "browser_widget.h"
+
+namespace doogie {
+
+class PageTree;
+class PageTreeItem;
+
+// Holds back restored pages so only a few load at once. The rest wait as
+// placeholders and are let in as loads finish, visible ones first, then
+// in tree order.
+class PageLoadScheduler : public QObject {
+  Q_OBJECT
+
+ public:
+  // Overridable w/ the pageLoad/maxConcurrent setting
+  static const int kDefaultMaxConcurrentLoads = 4;
+  // Loads that never say they're done stop counting after this
+  static const int kLoadTimeoutMs = 30000;
+
+  explicit PageLoadScheduler(PageTree* tree);
+
+  void Enqueue(PageTreeItem* item);
+  // Does nothing if it's not queued
+  void Remove(PageTreeItem* item);
+  // Counts against the limit until done, even if it never was queued
+  void TrackLoad(BrowserWidget* browser);
+
+  int QueueDepth() const { return pending_.size(); }
+  int ActiveLoads() const { return active_.size(); }
+
+ signals:
+  void QueueDepthChanged(int depth);
+
+ private:
+  // Deferred so a burst of changes only admits once
+  void ScheduleAdmit();
+  void Admit();
+  // Pending ones in the viewport, top to bottom
+  QList<PageTreeItem*> VisiblePending() const;
+  void LoadDone(BrowserWidget* browser);
+
+  PageTree* tree_;
+  int max_concurrent_;
+  QSet<PageTreeItem*> pending_;
+  // Pending in the order queued, which is tree order since they're queued
+  //  as they're restored. Ones let in early for being visible are left in
+  //  and skipped when reached.
+  QList<PageTreeItem*> order_;
+  QSet<BrowserWidget*> active_;
+  bool admit_scheduled_ = false;
+};
+
+}  // namespace doogie
+
+#endif  // DOOGIE_PAGE_LOAD_SCHEDULER_H_
@@ -4,7 +4,10 @@
 
 #include "action_manager.h"
 #include "bubble_settings_dialog.h"
+#include "metrics_registry.h"
 #include "profile.h"
+#include "tracing.h"
+#include "util.h"
 #include "workspace_dialog.h"
 #include "workspace_tree_item.h"
 
@@ -33,18 +36,44 @@ PageTree::PageTree(BrowserStack* browser_stack, QWidget* parent)
   header()->setSectionResizeMode(PageTreeItem::kCloseButtonColumn,
                                  QHeaderView::Fixed);
   setStyleSheet("QTreeWidget { border: none; }");
-
-  // Emit empty on row removal
+  // No widgets per row, the delegate paints the bubble and buttons
+  delegate_ = new PageTreeDelegate(this);
+  setItemDelegate(delegate_);
+  setMouseTracking(true);
+  viewport()->setAttribute(Qt::WA_Hover);
+  load_scheduler_ = new PageLoadScheduler(this);
+  suspension_policy_ = new SuspensionPolicy(this);
+
+  // Emit empty on row removal, and the rest shift up
   connect(model(), &QAbstractItemModel::rowsRemoved,
-          [=](const QModelIndex&, int, int) {
+          [=](const QModelIndex& parent, int, int) {
+    ChildrenChanged(parent.isValid() ?
+                      itemFromIndex(parent) : invisibleRootItem());
     if (topLevelItemCount() == 0) emit TreeEmpty();
   });
+  connect(this, &PageTree::ItemDestroyed, [=](PageTreeItem* item) {
+    mutated_parents_.remove(item);
+    PendingCloseDone(item);
+    if (filter_ids_.contains(item)) {
+      auto id = filter_ids_.take(item);
+      filter_items_.remove(id);
+      filter_index_.Remove(id);
+    }
+  });
+
+  // Every open page is in here, so it always has the full answer
+  filter_index_.SetComplete(true);
+  filter_timer_ = new QTimer(this);
+  filter_timer_->setSingleShot(true);
+  filter_timer_->setInterval(0);
+  connect(filter_timer_, &QTimer::timeout, this, &PageTree::ApplyFilter);
 
   // Each time one is selected, we need to make sure to show that on the stack
   connect(this, &QTreeWidget::currentItemChanged,
           [=](QTreeWidgetItem* current, QTreeWidgetItem* previous) {
-    // Deactivate previous
+    // Deactivate previous, it was in use up until now
     if (previous && previous->type() == kPageItemType) {
+      suspension_policy_->MarkActive(AsPageTreeItem(previous));
       auto old_font = previous->font(0);
       old_font.setBold(false);
       previous->setFont(0, old_font);
@@ -62,13 +91,16 @@ PageTree::PageTree(BrowserStack* browser_stack, QWidget* parent)
     // Sometimes current isn't set or isn't in the tree anymore
     if (current && indexFromItem(current).isValid()) {
       auto page_item = AsPageTreeItem(current);
+      suspension_policy_->MarkActive(page_item);
       auto new_font = page_item->font(0);
       new_font.setBold(true);
       page_item->setFont(0, new_font);
-      // Put the focus in the browser
-      if (page_item->Browser()) {
-        browser_stack_->setCurrentWidget(page_item->Browser());
-        page_item->Browser()->FocusBrowser();
+      // Closing many could otherwise create a browser for each one
+      //  that's current for a moment
+      if (mutation_depth_ > 0) {
+        show_current_after_mutation_ = true;
+      } else {
+        ShowItem(page_item);
       }
     } else {
       // As a special case, we need to set something as current
@@ -101,7 +133,7 @@ PageTree::PageTree(BrowserStack* browser_stack, QWidget* parent)
     // Close all items whose close button is checked
     QList<PageTreeItem*> items;
     for (const auto& item : Items()) {
-      if (item->CloseButton()->isChecked()) items << item;
+      if (item->CloseChecked()) items << item;
     }
     CloseItemsInReverseOrder(items);
   });
@@ -129,14 +161,8 @@ PageTree::PageTree(BrowserStack* browser_stack, QWidget* parent)
   QTimer::singleShot(0, [=]() { SetupInitialWorkspaces(); });
 }
 
-QMovie* PageTree::LoadingIconMovie() {
-  if (!loading_icon_movie_) {
-    loading_icon_movie_ = new QMovie(":/res/images/loading-icon.gif");
-    // We use a bad method to update the icon on frames of this,
-    // so slow it down.
-    loading_icon_movie_->setSpeed(70);
-  }
-  return loading_icon_movie_;
+void PageTree::SetItemLoading(PageTreeItem* item, bool loading) {
+  delegate_->SetLoading(indexFromItem(item), loading);
 }
 
 PageTreeItem* PageTree::CurrentItem() const {
@@ -149,8 +175,8 @@ PageTreeItem* PageTree::NewPage(const QString &url,
   Workspace::WorkspacePage page;
   if (parent) {
     page.SetWorkspaceId(parent->WorkspacePage().WorkspaceId());
-    page.SetParentId(parent->WorkspacePage().Id());
-    page.SetBubbleId(parent->Browser()->CurrentBubble().Id());
+    page.SetParentId(parent->WorkspacePage().Key());
+    page.SetBubbleId(parent->CurrentBubble().Id());
   } else {
     page.SetWorkspaceId(WorkspaceToAddUnder().Id());
     page.SetBubbleId(Bubble::DefaultBubble().Id());
@@ -161,7 +187,8 @@ PageTreeItem* PageTree::NewPage(const QString &url,
 
 PageTreeItem* PageTree::NewPage(Workspace::WorkspacePage* page,
                                 PageTreeItem* parent,
-                                bool make_current) {
+                                bool make_current,
+                                bool defer_load) {
   auto ok = false;
   auto bubble = Bubble::FromId(page->BubbleId(), &ok);
   auto start_url = page->Url();
@@ -170,11 +197,63 @@ PageTreeItem* PageTree::NewPage(Workspace::WorkspacePage* page,
     page->SetBubbleId(bubble.Id());
     page->SetSuspended(true);
   }
-  if (page->Suspended()) start_url = "";
+  // Suspended pages don't get a browser until they're needed, deferred
+  // ones not until the scheduler (or the user) gets to them
+  if (page->Suspended() || (defer_load && !make_current)) {
+    auto item = AddBrowser(nullptr, page, parent, make_current);
+    if (!page->Suspended() && item->Placeholder()) {
+      load_scheduler_->Enqueue(item);
+    }
+    return item;
+  }
   auto browser = browser_stack_->NewBrowser(bubble, start_url);
-  auto item = AddBrowser(browser, page, parent, make_current);
-  if (page->Suspended()) browser->SetSuspended(true, page->Url());
-  return item;
+  return AddBrowser(browser, page, parent, make_current);
+}
+
+BrowserWidget* PageTree::MaterializeItem(PageTreeItem* item) {
+  if (!item->Placeholder()) return item->Browser();
+  QElapsedTimer timer;
+  timer.start();
+  auto mem_before = Util::ResidentMemoryBytes();
+  const auto& page = item->WorkspacePage();
+  BrowserWidget* browser;
+  if (page.Suspended()) {
+    browser = browser_stack_->NewBrowser(item->CurrentBubble(), "");
+    // Before suspending, so it shows the screenshot from last time
+    item->ProvideScreenshotId(browser);
+    browser->SetSuspended(true, page.Url());
+  } else {
+    // Whether the scheduler let it in or not, it's loading now
+    load_scheduler_->Remove(item);
+    browser = browser_stack_->NewBrowser(item->CurrentBubble(), page.Url());
+    load_scheduler_->TrackLoad(browser);
+  }
+  item->SetBrowser(browser);
+  ConnectPageOpen(item);
+  ConnectIndexUpdates(item);
+  static auto materialize_time =
+      MetricsRegistry::GetHistogram("pageTree.materialize");
+  materialize_time->Record(timer.nsecsElapsed() / 1000);
+  if (timer.elapsed() > 100) {
+    qDebug() << "Materializing page" << item->WorkspacePage().Key() <<
+                "took" << timer.elapsed() << "ms, using about" <<
+                Util::FriendlyByteSize(qMax(Util::ResidentMemoryBytes() -
+                                            mem_before, 0ll));
+  }
+  return browser;
+}
+
+void PageTree::SuspendItem(PageTreeItem* item) {
+  if (item->Placeholder()) {
+    load_scheduler_->Remove(item);
+    item->SuspendPlaceholder();
+  } else {
+    item->Browser()->SetSuspended(true);
+  }
+}
+
+void PageTree::UnsuspendItem(PageTreeItem* item) {
+  MaterializeItem(item)->SetSuspended(false);
 }
 
 void PageTree::ApplyBubbleSelectMenu(QMenu* menu,
@@ -182,8 +261,9 @@ void PageTree::ApplyBubbleSelectMenu(QMenu* menu,
   // If there is a commonly selected one for all of them, we will mark
   // that one as checked and unable to be selected
   QString common_bubble_name;
+  qlonglong common_bubble_id = -1;
   for (auto item : apply_to_items) {
-    auto bubble_name = item->Browser()->CurrentBubble().Name();
+    auto bubble_name = item->CurrentBubble().Name();
     if (common_bubble_name.isNull()) {
       common_bubble_name = bubble_name;
     } else if (common_bubble_name != bubble_name) {
@@ -197,6 +277,7 @@ void PageTree::ApplyBubbleSelectMenu(QMenu* menu,
       action->setCheckable(true);
       action->setChecked(true);
       action->setDisabled(true);
+      common_bubble_id = bubble.Id();
     } else {
       connect(action, &QAction::triggered, [=]() {
         for (const auto& item : apply_to_items) {
@@ -215,6 +296,15 @@ void PageTree::ApplyBubbleSelectMenu(QMenu* menu,
       }
     }
   });
+  if (common_bubble_id >= 0) {
+    menu->addSeparator();
+    auto exempt = menu->addAction("Never Auto-Suspend Pages in Bubble",
+                                  [=](bool checked) {
+      SuspensionPolicy::SetBubbleExempt(common_bubble_id, checked);
+    });
+    exempt->setCheckable(true);
+    exempt->setChecked(SuspensionPolicy::BubbleExempt(common_bubble_id));
+  }
 }
 
 void PageTree::ApplyRecentWorkspacesMenu(QMenu* menu) {
@@ -258,6 +348,12 @@ void PageTree::ApplyWorkspaceMenu(QMenu* menu,
     Workspace::UpdateOpenWorkspaces(ids);
   })->setEnabled(item && curr_index < ids.length() - 1);
   menu->addSeparator();
+  auto exempt = menu->addAction("Never Auto-Suspend Pages", [=](bool checked) {
+    SuspensionPolicy::SetWorkspaceExempt(workspace.Id(), checked);
+  });
+  exempt->setCheckable(true);
+  exempt->setChecked(SuspensionPolicy::WorkspaceExempt(workspace.Id()));
+  menu->addSeparator();
   menu->addAction("Close", [=]() {
     CloseWorkspace(item);
   })->setEnabled(item);
@@ -288,6 +384,8 @@ void PageTree::ApplyWorkspaceMenu(QMenu* menu,
 }
 
 WorkspaceTreeItem* PageTree::OpenWorkspace(Workspace* workspace) {
+  Tracing::Span span("pageTree", "OpenWorkspace", workspace->Name());
+  MutationBatch batch(this);
   MakeWorkspaceExplicitIfPossible();
 
   // Mark as opened
@@ -303,6 +401,9 @@ WorkspaceTreeItem* PageTree::OpenWorkspace(Workspace* workspace) {
   Workspace::UpdateOpenWorkspaces(ids);
 
   // Let's add the children
+  QElapsedTimer timer;
+  timer.start();
+  auto mem_before = Util::ResidentMemoryBytes();
   QHash<qlonglong, PageTreeItem*> items_by_page_id;
   QHash<qlonglong, QList<Workspace::WorkspacePage>> children_by_parent_id;
   for (auto& child : workspace->AllChildren()) {
@@ -312,11 +413,29 @@ WorkspaceTreeItem* PageTree::OpenWorkspace(Workspace* workspace) {
       [=, &items_by_page_id, &add_children_of](qlonglong id) {
     auto parent = items_by_page_id.value(id);
     for (auto child : children_by_parent_id[id]) {
-      items_by_page_id[child.Id()] = NewPage(&child, parent, false);
+      items_by_page_id[child.Id()] = NewPage(&child, parent, false, true);
       add_children_of(child.Id());
     }
   };
   add_children_of(-1);
+  static auto open_time =
+      MetricsRegistry::GetHistogram("pageTree.openWorkspace");
+  open_time->Record(timer.nsecsElapsed() / 1000);
+  if (timer.elapsed() > 500) {
+    auto placeholders = 0;
+    for (auto page_item : items_by_page_id) {
+      if (page_item->Placeholder()) placeholders++;
+    }
+    auto mem_used = qMax(Util::ResidentMemoryBytes() - mem_before, 0ll);
+    qDebug() << "Opening workspace" << workspace->FriendlyName() << "with" <<
+                items_by_page_id.size() << "pages," << placeholders <<
+                "as placeholders, took" << timer.elapsed() <<
+                "ms using about" << Util::FriendlyByteSize(mem_used) << "(" <<
+                Util::FriendlyByteSize(
+                  items_by_page_id.isEmpty() ? 0.0 :
+                    static_cast<double>(mem_used) / items_by_page_id.size()) <<
+                "per page)";
+  }
   // Expand by default
   item->setExpanded(true);
   // Set the child expansions
@@ -342,6 +461,7 @@ WorkspaceTreeItem* PageTree::OpenWorkspace(Workspace* workspace) {
 }
 
 void PageTree::CloseAllWorkspaces() {
+  MutationBatch batch(this);
   if (has_implicit_workspace_) {
     // Just close all pages
     CloseItemsInReverseOrder(Items(), false);
@@ -358,6 +478,7 @@ void PageTree::CloseAllWorkspaces() {
 }
 
 void PageTree::WorkspaceAboutToDestroy(WorkspaceTreeItem* item) {
+  mutated_parents_.remove(item);
   // If current item is empty or no longer valid, we try to set the
   // current item as the one above us
   if (!currentItem() || !indexFromItem(currentItem()).isValid() ||
@@ -407,6 +528,30 @@ void PageTree::SetCurrentClosestTo(QTreeWidgetItem* item) {
   setCurrentItem(new_curr);
 }
 
+void PageTree::BeginMutation() {
+  if (mutation_depth_++ == 0) setUpdatesEnabled(false);
+}
+
+void PageTree::EndMutation() {
+  if (--mutation_depth_ > 0) return;
+  for (auto parent : mutated_parents_) RenumberChildren(parent);
+  mutated_parents_.clear();
+  setUpdatesEnabled(true);
+  // Written now in one go instead of waiting on the debounce
+  Workspace::WorkspacePage::FlushPendingUpdates();
+  if (show_current_after_mutation_) {
+    show_current_after_mutation_ = false;
+    auto item = CurrentItem();
+    if (item) ShowItem(item);
+  }
+}
+
+void PageTree::SetFilter(const QString& text) {
+  filter_ = text;
+  filter_timer_->stop();
+  ApplyFilter();
+}
+
 void PageTree::EditWorkspaceName(WorkspaceTreeItem* item) {
   if (item) {
     // Due to focusing issues, we defer this
@@ -457,6 +602,17 @@ Qt::DropActions PageTree::supportedDropActions() const {
 void PageTree::contextMenuEvent(QContextMenuEvent* event) {
   QMenu menu;
 
+  // The bubble icon only gets the bubble menu
+  auto index = indexAt(event->pos());
+  if (index.column() == PageTreeItem::kBubbleIconColumn) {
+    auto item = AsPageTreeItem(itemFromIndex(index));
+    if (item) {
+      ApplyBubbleSelectMenu(&menu, { item });
+      menu.exec(viewport()->mapToGlobal(visualRect(index).bottomLeft()));
+      return;
+    }
+  }
+
   menu.addAction(ActionManager::Action(ActionManager::NewTopLevelPage));
 
   // Single-page
@@ -472,13 +628,13 @@ void PageTree::contextMenuEvent(QContextMenuEvent* event) {
     });
     sub->addAction("Reload Page", [=]() {
       affected->Browser()->Refresh();
-    });
+    })->setEnabled(!affected->Placeholder());
     sub->addAction("Suspend Page", [=]() {
-      affected->Browser()->SetSuspended(true);
-    })->setEnabled(!affected->Browser()->Suspended());
+      SuspendItem(affected);
+    })->setEnabled(!affected->Suspended());
     sub->addAction("Unsuspend Page", [=]() {
-      affected->Browser()->SetSuspended(false);
-    })->setEnabled(affected->Browser()->Suspended());
+      UnsuspendItem(affected);
+    })->setEnabled(affected->Suspended());
     sub->addAction("Expand Tree", [=]() {
       affected->ExpandSelfAndChildren();
     })->setEnabled(affected->SelfOrAnyChildCollapsed());
@@ -675,6 +831,7 @@ void PageTree::dropEvent(QDropEvent* event) {
       // Due to bad internal Qt logic, we reset the current here
       auto current = currentItem();
       // Due to bad internal Qt logic, we reset expansion on drop completion
+      MutationBatch batch(this);
       QSet<PageTreeItem*> expanded_selected;
       for (const auto item_top : SelectedItemsOnlyHighestLevel()) {
         for (const auto item : item_top->SelfAndChildren()) {
@@ -730,11 +887,8 @@ QMimeData* PageTree::mimeData(const QList<QTreeWidgetItem*> items) const {
   for (const auto& item : items) {
     auto page_item = AsPageTreeItem(item);
     if (page_item) {
-      auto browser = page_item->Browser();
-      if (browser) {
-        auto url = browser->CurrentUrl();
-        if (!url.isEmpty()) urls.append(QUrl(url));
-      }
+      auto url = page_item->CurrentUrl();
+      if (!url.isEmpty()) urls.append(QUrl(url));
     }
   }
   if (!urls.isEmpty()) ret->setUrls(urls);
@@ -746,6 +900,8 @@ QStringList PageTree::mimeTypes() const {
 }
 
 void PageTree::mouseDoubleClickEvent(QMouseEvent *event) {
+  // Like a button, a double click is just another press
+  if (event->button() == Qt::LeftButton && ButtonPress(event->pos())) return;
   if (itemAt(event->pos())) {
     QTreeWidget::mouseDoubleClickEvent(event);
   } else {
@@ -759,6 +915,7 @@ void PageTree::mouseDoubleClickEvent(QMouseEvent *event) {
 }
 
 void PageTree::mousePressEvent(QMouseEvent* event) {
+  if (event->button() == Qt::LeftButton && ButtonPress(event->pos())) return;
   // We start a rubber band selection if left of the tree or if there is no
   // item where we pressed.
   auto item = itemAt(event->pos());
@@ -791,6 +948,20 @@ void PageTree::mousePressEvent(QMouseEvent* event) {
 }
 
 void PageTree::mouseMoveEvent(QMouseEvent* event) {
+  // Dragging across close buttons toggles each one once
+  if (close_dragging_) {
+    QTreeWidgetItem* item = nullptr;
+    auto index = indexAt(event->pos());
+    if (index.column() == PageTreeItem::kCloseButtonColumn) {
+      item = itemFromIndex(index);
+    }
+    auto page_item = AsPageTreeItem(item);
+    if (page_item && item != close_drag_last_seen_) {
+      page_item->SetCloseChecked(!page_item->CloseChecked());
+    }
+    close_drag_last_seen_ = item;
+    return;
+  }
   // If we are rubber band selecting, keep using that
   if (rubber_band_ && !rubber_band_->isHidden()) {
     // Restore the selection we knew
@@ -817,6 +988,12 @@ void PageTree::mouseMoveEvent(QMouseEvent* event) {
 }
 
 void PageTree::mouseReleaseEvent(QMouseEvent* event) {
+  if (close_dragging_) {
+    close_dragging_ = false;
+    close_drag_last_seen_ = nullptr;
+    emit ItemCloseRelease();
+    return;
+  }
   // End rubber band selection
   if (rubber_band_ && !rubber_band_->isHidden()) {
     rubber_band_->hide();
@@ -838,9 +1015,7 @@ void PageTree::rowsInserted(const QModelIndex& parent, int start, int end) {
     }
     return;
   }
-  // We have to override this to re-add the child widget due to how row
-  // movement occurs.
-  // Ref: https://stackoverflow.com/questions/25559221/qtreewidgetitem-issue-items-set-using-setwidgetitem-are-dispearring-after-movin
+  // Moved rows need their workspace and parent persisted
   for (int i = start; i <= end; i++) {
     auto item = itemFromIndex(model()->index(i, 0, parent));
     if (item && item->type() == kPageItemType) {
@@ -849,6 +1024,10 @@ void PageTree::rowsInserted(const QModelIndex& parent, int start, int end) {
       AsWorkspaceTreeItem(item)->AfterAdded();
     }
   }
+  ChildrenChanged(parent.isValid() ?
+                    itemFromIndex(parent) : invisibleRootItem());
+  // Moved rows lose being hidden
+  if (FilterActive()) filter_timer_->start();
   QTreeWidget::rowsInserted(parent, start, end);
 }
 
@@ -878,6 +1057,26 @@ WorkspaceTreeItem* PageTree::AsWorkspaceTreeItem(QTreeWidgetItem* item) const {
   return nullptr;
 }
 
+bool PageTree::ButtonPress(const QPoint& pos) {
+  auto index = indexAt(pos);
+  if (index.column() != PageTreeItem::kCloseButtonColumn) return false;
+  auto item = itemFromIndex(index);
+  auto workspace_item = AsWorkspaceTreeItem(item);
+  if (workspace_item) {
+    QMenu menu;
+    ApplyWorkspaceMenu(&menu, workspace_item->CurrentWorkspace(),
+                       workspace_item);
+    menu.exec(viewport()->mapToGlobal(visualRect(index).bottomLeft()));
+    return true;
+  }
+  auto page_item = AsPageTreeItem(item);
+  if (!page_item) return false;
+  close_dragging_ = true;
+  close_drag_last_seen_ = page_item;
+  page_item->SetCloseChecked(true);
+  return true;
+}
+
 void PageTree::SetupActions() {
   connect(ActionManager::Action(ActionManager::NewTopLevelPage),
           &QAction::triggered, [=]() {
@@ -899,10 +1098,10 @@ void PageTree::SetupActions() {
           [=]() { CurrentItem()->Browser()->Refresh(); });
   connect(ActionManager::Action(ActionManager::SuspendPage),
           &QAction::triggered,
-          [=]() { CurrentItem()->Browser()->SetSuspended(true); });
+          [=]() { SuspendItem(CurrentItem()); });
   connect(ActionManager::Action(ActionManager::UnsuspendPage),
           &QAction::triggered,
-          [=]() { CurrentItem()->Browser()->SetSuspended(false); });
+          [=]() { UnsuspendItem(CurrentItem()); });
   connect(ActionManager::Action(ActionManager::Stop),
           &QAction::triggered,
           [=]() { CurrentItem()->Browser()->Stop(); });
@@ -971,19 +1170,19 @@ void PageTree::SetupActions() {
   connect(ActionManager::Action(ActionManager::ReloadSelectedPages),
           &QAction::triggered, [=]() {
     for (auto item : SelectedItems()) {
-      item->Browser()->Refresh();
+      if (!item->Placeholder()) item->Browser()->Refresh();
     }
   });
   connect(ActionManager::Action(ActionManager::SuspendSelectedPages),
           &QAction::triggered, [=]() {
     for (auto item : SelectedItems()) {
-      item->Browser()->SetSuspended(true);
+      SuspendItem(item);
     }
   });
   connect(ActionManager::Action(ActionManager::UnsuspendSelectedPages),
           &QAction::triggered, [=]() {
     for (auto item : SelectedItems()) {
-      item->Browser()->SetSuspended(false);
+      UnsuspendItem(item);
     }
   });
   connect(ActionManager::Action(ActionManager::ExpandSelectedTrees),
@@ -1003,6 +1202,7 @@ void PageTree::SetupActions() {
   // can be ambiguous depending on which you duplicate first.
   connect(ActionManager::Action(ActionManager::DuplicateSelectedTrees),
           &QAction::triggered, [=]() {
+    MutationBatch batch(this);
     for (auto item : SelectedItemsOnlyHighestLevel()) {
       DuplicateTree(item);
     }
@@ -1010,6 +1210,7 @@ void PageTree::SetupActions() {
   connect(ActionManager::Action(ActionManager::CloseSelectedPages),
           &QAction::triggered, [=]() {
     // Go backwards and expand before closing
+    MutationBatch batch(this);
     auto items = SelectedItems();
     for (auto i = items.crbegin(); i != items.crend(); i++) {
       (*i)->setExpanded(true);
@@ -1018,6 +1219,7 @@ void PageTree::SetupActions() {
   });
   connect(ActionManager::Action(ActionManager::CloseSelectedTrees),
           &QAction::triggered, [=]() {
+    MutationBatch batch(this);
     for (auto item : SelectedItemsOnlyHighestLevel()) {
       CloseItem(item, true, true);
     }
@@ -1025,6 +1227,7 @@ void PageTree::SetupActions() {
   connect(ActionManager::Action(ActionManager::CloseNonSelectedPages),
           &QAction::triggered, [=]() {
     // Expand non-selected and close in reverse
+    MutationBatch batch(this);
     auto items = Items();
     for (auto i = items.crbegin(); i != items.crend(); i++) {
       if (!(*i)->isSelected()) {
@@ -1037,6 +1240,7 @@ void PageTree::SetupActions() {
           &QAction::triggered, [=]() {
     // Basically go in reverse and expand+close anything not selected
     // and without a selected parent.
+    MutationBatch batch(this);
     auto items = Items();
     for (auto i = items.crbegin(); i != items.crend(); i++) {
       if (!(*i)->SelectedOrHasSelectedParent()) {
@@ -1049,19 +1253,19 @@ void PageTree::SetupActions() {
   connect(ActionManager::Action(ActionManager::ReloadAllPages),
           &QAction::triggered, [=]() {
     for (auto item : Items()) {
-      item->Browser()->Refresh();
+      if (!item->Placeholder()) item->Browser()->Refresh();
     }
   });
   connect(ActionManager::Action(ActionManager::SuspendAllPages),
           &QAction::triggered, [=]() {
     for (auto item : Items()) {
-      item->Browser()->SetSuspended(true);
+      SuspendItem(item);
     }
   });
   connect(ActionManager::Action(ActionManager::UnsuspendAllPages),
           &QAction::triggered, [=]() {
     for (auto item : Items()) {
-      item->Browser()->SetSuspended(false);
+      UnsuspendItem(item);
     }
   });
   connect(ActionManager::Action(ActionManager::ExpandAllTrees),
@@ -1208,8 +1412,17 @@ PageTreeItem* PageTree::AddBrowser(QPointer<BrowserWidget> browser,
     setCurrentItem(browser_item, 0, QItemSelectionModel::Current);
   }
   browser_item->setExpanded(page->Expanded());
+  IndexItem(browser_item);
+  if (browser) {
+    ConnectPageOpen(browser_item);
+    ConnectIndexUpdates(browser_item);
+  }
+  return browser_item;
+}
+
+void PageTree::ConnectPageOpen(PageTreeItem* browser_item) {
   // Make all tab opens open as child
-  connect(browser, &BrowserWidget::PageOpen,
+  connect(browser_item->Browser(), &BrowserWidget::PageOpen,
           [=](CefHandler::WindowOpenType type,
               const QString& url,
               bool user_gesture) {
@@ -1230,12 +1443,97 @@ PageTreeItem* PageTree::AddBrowser(QPointer<BrowserWidget> browser,
     auto curr_browser = browser_stack_->CurrentBrowser();
     if (curr_browser) curr_browser->FocusBrowser();
   });
-  return browser_item;
+}
+
+void PageTree::ShowItem(PageTreeItem* item) {
+  // Put the focus in the browser, creating it if it's a placeholder
+  auto browser = MaterializeItem(item);
+  if (browser) {
+    browser_stack_->setCurrentWidget(browser);
+    browser->FocusBrowser();
+  }
+}
+
+void PageTree::ChildrenChanged(QTreeWidgetItem* parent) {
+  if (mutation_depth_ > 0) {
+    mutated_parents_.insert(parent);
+  } else {
+    RenumberChildren(parent);
+  }
+}
+
+void PageTree::RenumberChildren(QTreeWidgetItem* parent) {
+  for (int i = 0; i < parent->childCount(); i++) {
+    auto item = AsPageTreeItem(parent->child(i));
+    if (item) item->SetPos(i);
+  }
+}
+
+void PageTree::IndexItem(PageTreeItem* item) {
+  auto id = filter_ids_.value(item, -1);
+  if (id < 0) {
+    id = next_filter_id_++;
+    filter_ids_[item] = id;
+    filter_items_[id] = item;
+  }
+  FrecencyIndex::Entry entry;
+  entry.id = id;
+  entry.url = item->CurrentUrl();
+  entry.title = item->text(0);
+  filter_index_.Upsert(entry);
+  if (FilterActive()) filter_timer_->start();
+}
+
+void PageTree::ConnectIndexUpdates(PageTreeItem* item) {
+  // The item has already applied these by the time we get them
+  auto browser = item->Browser();
+  connect(browser, &BrowserWidget::TitleChanged, [=]() { IndexItem(item); });
+  connect(browser, &BrowserWidget::LoadingStateChanged,
+          [=]() { IndexItem(item); });
+}
+
+bool PageTree::FilterActive() const {
+  return !FrecencyIndex::Tokens(filter_).isEmpty();
+}
+
+void PageTree::ApplyFilter() {
+  QElapsedTimer timer;
+  timer.start();
+  auto active = FilterActive();
+  QSet<QTreeWidgetItem*> visible;
+  if (active) {
+    QList<FrecencyIndex::Entry> matches;
+    filter_index_.Find(filter_, filter_index_.Size(), &matches);
+    for (const auto& match : matches) {
+      // Stop at the first ancestor we already have
+      QTreeWidgetItem* item = filter_items_.value(match.id);
+      while (item && !visible.contains(item)) {
+        visible.insert(item);
+        item = item->parent();
+      }
+    }
+  }
+  // Only touch the rows that change
+  QTreeWidgetItemIterator it(this);
+  while (*it) {
+    if ((*it)->type() == kPageItemType) {
+      auto hide = active && !visible.contains(*it);
+      if (hide != (*it)->isHidden()) (*it)->setHidden(hide);
+    }
+    it++;
+  }
+  static auto filter_time = MetricsRegistry::GetHistogram("pageTree.filter");
+  filter_time->Record(timer.nsecsElapsed() / 1000);
+  if (timer.elapsed() > 16) {
+    qDebug() << "Filtering" << filter_index_.Size() << "pages took" <<
+                timer.elapsed() << "ms";
+  }
 }
 
 void PageTree::CloseWorkspace(WorkspaceTreeItem* item, bool send_close_event) {
   // Do nothing if no item
   if (!item) return;
+  MutationBatch batch(this);
   // If it's empty, just destroy it
   if (item->childCount() == 0) {
     auto id = item->CurrentWorkspace().Id();
@@ -1258,6 +1556,7 @@ void PageTree::CloseItem(PageTreeItem* item,
                          bool force_close_children) {
   // Eagerly skip this if the item ain't a thing anymore
   if (!item) return;
+  MutationBatch batch(this);
   item->SetPersistNextCloseToWorkspace(workspace_persist);
   // We only close children if we're not expanded unless we're foreced
   if (force_close_children || !item->isExpanded()) {
@@ -1271,22 +1570,44 @@ void PageTree::CloseItem(PageTreeItem* item,
       CloseItem(child, workspace_persist, force_close_children);
     }
   }
+  // Browsers close later, so their reparenting and renumbering stay in
+  //  the batch only if it's held open until then
+  auto browser = item->Browser();
+  if (browser && !pending_closes_.contains(item)) {
+    pending_closes_.insert(item);
+    BeginMutation();
+    connect(browser, &BrowserWidget::CloseCancelled,
+            this, [=]() { PendingCloseDone(item); });
+    // Not w/ repaints off while the user is asked to leave the page
+    connect(browser, &BrowserWidget::AboutToShowJSDialog,
+            this, [=]() { PendingCloseDone(item); });
+    QTimer::singleShot(kPendingCloseTimeoutMs,
+                       this, [=]() { PendingCloseDone(item); });
+  }
   // Now we can close myself
-  item->Browser()->TryClose();
+  item->TryClose();
 }
 
 void PageTree::CloseItemsInReverseOrder(QList<PageTreeItem*> items,
                                         bool workspace_persist) {
+  MutationBatch batch(this);
   for (auto i = items.crbegin(); i != items.crend(); i++) {
     CloseItem(*i, workspace_persist);
   }
 }
 
+void PageTree::PendingCloseDone(PageTreeItem* item) {
+  if (!pending_closes_.remove(item)) return;
+  // Not while the item is still going away
+  QTimer::singleShot(0, this, [=]() { EndMutation(); });
+}
+
 void PageTree::DuplicateTree(PageTreeItem* item, PageTreeItem* to_parent) {
   // No parent means grab from item (which can still be no parent)
   if (!to_parent) to_parent = item->Parent();
+  MutationBatch batch(this);
   // Duplicate myself first, then children
-  auto new_item = NewPage(item->Browser()->CurrentUrl(), to_parent, false);
+  auto new_item = NewPage(item->CurrentUrl(), to_parent, false);
   for (int i = 0; i < item->childCount(); i++) {
     DuplicateTree(AsPageTreeItem(item->child(i)), new_item);
   }
@@ -1329,12 +1650,12 @@ QList<PageTreeItem*> PageTree::SelectedItemsOnlyHighestLevel() {
 }
 
 QList<PageTreeItem*> PageTree::SameHostPages(PageTreeItem* to_comp) {
-  auto host = QUrl(to_comp->Browser()->CurrentUrl()).host();
+  auto host = QUrl(to_comp->CurrentUrl()).host();
   QList<PageTreeItem*> ret;
   QTreeWidgetItemIterator it(this);
   while (*it) {
     auto item = AsPageTreeItem(*it);
-    if (item && host == QUrl(item->Browser()->CurrentUrl()).host()) {
+    if (item && host == QUrl(item->CurrentUrl()).host()) {
       ret.append(item);
     }
     it++;
@@ -1373,6 +1694,7 @@ WorkspaceTreeItem* PageTree::WorkspaceTreeItemToAddUnder() const {
 
 void PageTree::MakeWorkspaceExplicitIfPossible() {
   if (!has_implicit_workspace_) return;
+  MutationBatch batch(this);
   auto current = currentItem();
   has_implicit_workspace_ = false;
   auto item = new WorkspaceTreeItem(implicit_workspace_);
@@ -1392,6 +1714,7 @@ void PageTree::MakeWorkspaceExplicitIfPossible() {
 
 void PageTree::MakeWorkspaceImplicitIfPossible() {
   if (has_implicit_workspace_ || topLevelItemCount() != 1) return;
+  MutationBatch batch(this);
   auto current = currentItem();
   has_implicit_workspace_ = true;
   auto item = AsWorkspaceTreeItem(takeTopLevelItem(0));
@@ -3,9 +3,15 @@
 
 #include <QtWidgets>
 
+#include <limits>
+
 #include "browser_stack.h"
 #include "browser_widget.h"
+#include "frecency_index.h"
+#include "page_load_scheduler.h"
+#include "page_tree_delegate.h"
 #include "page_tree_item.h"
+#include "suspension_policy.h"
 #include "workspace.h"
 #include "workspace_tree_item.h"
 
@@ -18,16 +24,28 @@ class PageTree : public QTreeWidget {
  public:
   static const int kPageItemType = QTreeWidgetItem::UserType + 1;
   static const int kWorkspaceItemType = QTreeWidgetItem::UserType + 2;
+  // A close that takes longer than this stops holding its batch open
+  static const int kPendingCloseTimeoutMs = 5000;
 
   explicit PageTree(BrowserStack* browser_stack, QWidget* parent = nullptr);
-  QMovie* LoadingIconMovie();
+  // Animated by the delegate until unset
+  void SetItemLoading(PageTreeItem* item, bool loading);
   PageTreeItem* CurrentItem() const;
   PageTreeItem* NewPage(const QString& url,
                         PageTreeItem* parent,
                         bool make_current);
+  // Deferred loads are left to the load scheduler unless made current
   PageTreeItem* NewPage(Workspace::WorkspacePage* page,
                         PageTreeItem* parent,
-                        bool make_current);
+                        bool make_current,
+                        bool defer_load = false);
+  // Gives a placeholder item its browser, still suspended if the page is,
+  //  otherwise loading. Just returns the browser if it already has one.
+  BrowserWidget* MaterializeItem(PageTreeItem* item);
+  void SuspendItem(PageTreeItem* item);
+  void UnsuspendItem(PageTreeItem* item);
+  PageLoadScheduler* LoadScheduler() const { return load_scheduler_; }
+  SuspensionPolicy* Suspension() const { return suspension_policy_; }
   void ApplyBubbleSelectMenu(QMenu* menu,
                              QList<PageTreeItem*> apply_to_items);
 
@@ -48,6 +66,20 @@ class PageTree : public QTreeWidget {
 
   void SetCurrentClosestTo(QTreeWidgetItem* item);
 
+  // Structural changes between these are applied w/ repaints off and
+  //  persisted once the outermost one ends: a single pos renumbering per
+  //  affected parent and one write transaction. Switching to a new
+  //  current page also waits until then. Nests. Pages w/ a browser close
+  //  asynchronously, so one that starts closing in a batch holds it open
+  //  until it's done.
+  void BeginMutation();
+  void EndMutation();
+
+  // Hides the pages whose title or URL doesn't have a word starting w/
+  //  each word of the text, but keeps ancestors of the ones that do.
+  //  Empty shows them all again.
+  void SetFilter(const QString& text);
+
   void EditWorkspaceName(WorkspaceTreeItem* item);
 
   QJsonObject DebugDump() const;
@@ -78,20 +110,48 @@ class PageTree : public QTreeWidget {
       const QModelIndex& index, const QEvent* event) const override;
 
  private:
+  // Scoped BeginMutation/EndMutation
+  class MutationBatch {
+   public:
+    explicit MutationBatch(PageTree* tree) : tree_(tree) {
+      tree_->BeginMutation();
+    }
+    ~MutationBatch() { tree_->EndMutation(); }
+
+   private:
+    PageTree* tree_;
+  };
+
   PageTreeItem* AsPageTreeItem(QTreeWidgetItem* item) const;
   WorkspaceTreeItem* AsWorkspaceTreeItem(QTreeWidgetItem* item) const;
+  // The close and workspace menu buttons are painted by the delegate, so
+  //  we handle their clicks. True if the press was on one.
+  bool ButtonPress(const QPoint& pos);
   void SetupActions();
   void SetupInitialWorkspaces();
   PageTreeItem* AddBrowser(QPointer<BrowserWidget> browser,
                            Workspace::WorkspacePage* page,
                            PageTreeItem* parent,
                            bool make_current);
+  void ConnectPageOpen(PageTreeItem* browser_item);
+  // Puts the page's browser in front, creating it if needed
+  void ShowItem(PageTreeItem* item);
+  // Renumbers now or, if mutating, at the end
+  void ChildrenChanged(QTreeWidgetItem* parent);
+  void RenumberChildren(QTreeWidgetItem* parent);
+  // Adds or updates the page in the filter index
+  void IndexItem(PageTreeItem* item);
+  void ConnectIndexUpdates(PageTreeItem* item);
+  bool FilterActive() const;
+  void ApplyFilter();
   void CloseWorkspace(WorkspaceTreeItem* item, bool send_close_event = true);
   void CloseItem(PageTreeItem* item,
                  bool workspace_persist = true,
                  bool force_close_children = false);
   void CloseItemsInReverseOrder(QList<PageTreeItem*> items,
                                 bool workspace_persist = true);
+  // Ends the mutation held for the item's close, if any
+  void PendingCloseDone(PageTreeItem* item);
   void DuplicateTree(PageTreeItem* item, PageTreeItem* to_parent = nullptr);
   QList<PageTreeItem*> Items();
   QList<PageTreeItem*> SelectedItems();
@@ -105,10 +165,31 @@ class PageTree : public QTreeWidget {
   void MakeWorkspaceImplicitIfPossible();
 
   BrowserStack* browser_stack_ = nullptr;
-  QMovie* loading_icon_movie_ = nullptr;
+  PageTreeDelegate* delegate_ = nullptr;
+  PageLoadScheduler* load_scheduler_ = nullptr;
+  SuspensionPolicy* suspension_policy_ = nullptr;
   QRubberBand* rubber_band_ = nullptr;
   QPoint rubber_band_origin_;
   QItemSelection rubber_band_orig_selected_;
+  bool close_dragging_ = false;
+  // Only compared, never dereferenced
+  QTreeWidgetItem* close_drag_last_seen_ = nullptr;
+  int mutation_depth_ = 0;
+  // Removed as they are destroyed
+  QSet<QTreeWidgetItem*> mutated_parents_;
+  bool show_current_after_mutation_ = false;
+  // Each holds a mutation open until its browser closes. Only compared,
+  //  never dereferenced.
+  QSet<PageTreeItem*> pending_closes_;
+
+  // All open pages, only used for filtering so not frecency bound
+  FrecencyIndex filter_index_ { std::numeric_limits<int>::max() };
+  QHash<PageTreeItem*, qlonglong> filter_ids_;
+  QHash<qlonglong, PageTreeItem*> filter_items_;
+  qlonglong next_filter_id_ = 0;
+  QString filter_;
+  // Changes while filtering are re-applied together
+  QTimer* filter_timer_ = nullptr;
 
   Workspace implicit_workspace_;
   bool has_implicit_workspace_ = false;
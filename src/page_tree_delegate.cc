@@ -0,0 +1,97 @@
+#include "page_tree_delegate.h"
+
+#include "page_tree_item.h"
+
+namespace doogie {
+
+PageTreeDelegate::PageTreeDelegate(QAbstractItemView* view)
+    : QStyledItemDelegate(view), view_(view) {
+}
+
+void PageTreeDelegate::paint(QPainter* painter,
+                             const QStyleOptionViewItem& option,
+                             const QModelIndex& index) const {
+  QStyleOptionViewItem opt(option);
+  initStyleOption(&opt, index);
+  auto style = opt.widget ? opt.widget->style() : QApplication::style();
+  if (index.column() == 0) {
+    if (loading_frame_.isNull() || !index.data(kLoadingRole).toBool()) {
+      QStyledItemDelegate::paint(painter, option, index);
+      return;
+    }
+    // Keep the space for the icon, but draw the frame in it instead
+    opt.icon = QIcon();
+    opt.features |= QStyleOptionViewItem::HasDecoration;
+    style->drawControl(QStyle::CE_ItemViewItem, &opt, painter, opt.widget);
+    painter->drawPixmap(
+          style->subElementRect(QStyle::SE_ItemViewItemDecoration,
+                                &opt, opt.widget),
+          loading_frame_);
+    return;
+  }
+  // Background and selection as usual, we draw the icon ourselves
+  auto icon = opt.icon;
+  opt.icon = QIcon();
+  opt.features &= ~QStyleOptionViewItem::HasDecoration;
+  style->drawControl(QStyle::CE_ItemViewItem, &opt, painter, opt.widget);
+
+  auto mode = QIcon::Normal;
+  if (!opt.state.testFlag(QStyle::State_Enabled)) mode = QIcon::Disabled;
+  if (index.column() == PageTreeItem::kCloseButtonColumn) {
+    auto checked = index.data(kButtonCheckedRole).toBool();
+    if (checked || opt.state.testFlag(QStyle::State_MouseOver)) {
+      QStyleOptionToolButton button;
+      button.initFrom(opt.widget);
+      button.rect = opt.rect;
+      button.state = QStyle::State_Enabled | QStyle::State_AutoRaise;
+      if (checked) {
+        button.state |= QStyle::State_On | QStyle::State_Sunken;
+      } else {
+        button.state |= QStyle::State_MouseOver | QStyle::State_Raised;
+      }
+      style->drawPrimitive(QStyle::PE_PanelButtonTool,
+                           &button, painter, opt.widget);
+    }
+  }
+  icon.paint(painter, opt.rect, Qt::AlignCenter, mode);
+}
+
+void PageTreeDelegate::SetLoading(const QModelIndex& index, bool loading) {
+  if (!index.isValid()) return;
+  if (index.data(kLoadingRole).toBool() != loading) {
+    view_->model()->setData(index, loading, kLoadingRole);
+  }
+  if (!loading) {
+    loading_.remove(index);
+    if (loading_.isEmpty() && loading_movie_) loading_movie_->stop();
+    return;
+  }
+  loading_.insert(index);
+  if (!loading_movie_) {
+    loading_movie_ = new QMovie(":/res/images/loading-icon.gif",
+                                QByteArray(), this);
+    connect(loading_movie_, &QMovie::frameChanged,
+            this, &PageTreeDelegate::LoadingFrameChanged);
+  }
+  if (loading_movie_->state() != QMovie::Running) loading_movie_->start();
+}
+
+void PageTreeDelegate::LoadingFrameChanged() {
+  loading_frame_ = loading_movie_->currentPixmap();
+  auto viewport = view_->viewport();
+  auto visible = viewport->rect();
+  auto it = loading_.begin();
+  while (it != loading_.end()) {
+    if (!it->isValid()) {
+      it = loading_.erase(it);
+      continue;
+    }
+    // Empty for rows under collapsed parents
+    auto rect = view_->visualRect(*it);
+    if (rect.intersects(visible)) viewport->update(rect);
+    it++;
+  }
+  if (loading_.isEmpty()) loading_movie_->stop();
+}
+
+}  // namespace doogie
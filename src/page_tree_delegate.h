@@ -0,0 +1,43 @@
+#ifndef DOOGIE_PAGE_TREE_DELEGATE_H_
+#define DOOGIE_PAGE_TREE_DELEGATE_H_
+
+#include <QtWidgets>
+
+namespace doogie {
+
+// Paints the page tree's bubble icon and button columns so rows don't
+// need widgets of their own. The button column (close for pages, menu
+// for workspaces) is drawn like an auto-raise tool button. Loading rows
+// get their favicon replaced by a frame of one shared animation.
+class PageTreeDelegate : public QStyledItemDelegate {
+  Q_OBJECT
+
+ public:
+  // Bool data on the button column, drawn as pressed when set
+  static const int kButtonCheckedRole = Qt::UserRole + 1;
+  // Bool data on the first column, animated while set
+  static const int kLoadingRole = Qt::UserRole + 2;
+
+  explicit PageTreeDelegate(QAbstractItemView* view);
+
+  void paint(QPainter* painter,
+             const QStyleOptionViewItem& option,
+             const QModelIndex& index) const override;
+
+  // Sets the loading data on the row and animates it while it's set
+  void SetLoading(const QModelIndex& index, bool loading);
+
+ private:
+  // Only repaints the loading rows that can be seen
+  void LoadingFrameChanged();
+
+  QAbstractItemView* view_;
+  QMovie* loading_movie_ = nullptr;
+  QPixmap loading_frame_;
+  // Removed rows become invalid and are dropped on the next frame
+  QSet<QPersistentModelIndex> loading_;
+};
+
+}  // namespace doogie
+
+#endif  // DOOGIE_PAGE_TREE_DELEGATE_H_
@@ -12,18 +12,34 @@ PageTreeDock::PageTreeDock(BrowserStack* browser_stack, QWidget* parent)
   // Create tree
   tree_ = new PageTree(browser_stack, this);
   auto update_title = [=]() {
+    QString title = "Pages";
     if (tree_->HasImplicitWorkspace()) {
-      setWindowTitle(QString("Pages - Workspace: ") +
-                     tree_->ImplicitWorkspace().FriendlyName());
-    } else {
-      setWindowTitle("Pages");
+      title += " - Workspace: " + tree_->ImplicitWorkspace().FriendlyName();
     }
+    auto waiting = tree_->LoadScheduler()->QueueDepth();
+    if (waiting > 0) title += QString(" (%1 waiting to load)").arg(waiting);
+    setWindowTitle(title);
   };
   update_title();
   connect(tree_, &PageTree::WorkspaceImplicitnessChanged, update_title);
+  connect(tree_->LoadScheduler(), &PageLoadScheduler::QueueDepthChanged,
+          update_title);
   connect(tree_, &PageTree::TreeEmpty, this, &PageTreeDock::TreeEmpty);
+
+  auto filter = new QLineEdit;
+  filter->setPlaceholderText("Filter pages");
+  filter->setClearButtonEnabled(true);
+  connect(filter, &QLineEdit::textChanged, tree_, &PageTree::SetFilter);
+
+  auto layout = new QVBoxLayout;
+  layout->setContentsMargins(0, 0, 0, 0);
+  layout->setSpacing(0);
+  layout->addWidget(filter);
+  layout->addWidget(tree_, 1);
+  auto widg = new QWidget;
+  widg->setLayout(layout);
   setFocusProxy(tree_);
-  setWidget(tree_);
+  setWidget(widg);
 }
 
 void PageTreeDock::NewPage(const QString &url,
@@ -1,6 +1,8 @@
 #include "page_tree_item.h"
 
 #include "page_tree.h"
+#include "page_tree_delegate.h"
+#include "screenshot_cache.h"
 #include "util.h"
 #include "workspace_tree_item.h"
 
@@ -15,13 +17,75 @@ PageTreeItem::PageTreeItem(QPointer<BrowserWidget> browser,
   if (!workspace_page_.Icon().isNull()) {
     setIcon(0, workspace_page_.Icon());
     setText(0, workspace_page_.Title());
-    browser->SetUrlText(workspace_page_.Url());
+    if (browser_) browser_->SetUrlText(workspace_page_.Url());
+  } else if (!browser_) {
+    setText(0, workspace_page_.Title().isEmpty() ?
+        workspace_page_.Url() : workspace_page_.Title());
   } else {
     setText(0, "(New Window)");
   }
+  setToolTip(0, text(0));
+  ApplyBubbleIcon();
+  setIcon(kCloseButtonColumn,
+          Util::CachedIcon(":/res/images/fontawesome/times.png"));
 
   setFlags(Qt::ItemIsSelectable | Qt::ItemIsDragEnabled |
            Qt::ItemIsDropEnabled | Qt::ItemIsEnabled);
+  if (browser_) {
+    ConnectBrowser();
+  } else {
+    ApplySuspendedLook(true);
+  }
+}
+
+QPointer<BrowserWidget> PageTreeItem::Browser() const {
+  return valid_ ? browser_ : nullptr;
+}
+
+void PageTreeItem::SetBrowser(QPointer<BrowserWidget> browser) {
+  if (browser_ || !browser) return;
+  browser_ = browser;
+  ProvideScreenshotId(browser_);
+  browser_->SetUrlText(workspace_page_.Url());
+  ApplySuspendedLook(browser_->Suspended());
+  ConnectBrowser();
+}
+
+void PageTreeItem::ProvideScreenshotId(BrowserWidget* browser) {
+  browser->SetScreenshotIdLookup([this]() { return workspace_page_.Id(); });
+}
+
+void PageTreeItem::SuspendPlaceholder() {
+  if (!Placeholder() || workspace_page_.Suspended()) return;
+  workspace_page_.SetSuspended(true);
+  workspace_page_.Persist();
+}
+
+QString PageTreeItem::CurrentUrl() const {
+  return browser_ ? browser_->CurrentUrl() : workspace_page_.Url();
+}
+
+Bubble PageTreeItem::CurrentBubble() const {
+  if (browser_) return browser_->CurrentBubble();
+  auto ok = false;
+  auto bubble = Bubble::FromId(workspace_page_.BubbleId(), &ok);
+  return ok ? bubble : Bubble::DefaultBubble();
+}
+
+bool PageTreeItem::Suspended() const {
+  return browser_ ? browser_->Suspended() : workspace_page_.Suspended();
+}
+
+void PageTreeItem::TryClose() {
+  if (browser_) {
+    browser_->TryClose();
+  } else {
+    Closed();
+  }
+}
+
+void PageTreeItem::ConnectBrowser() {
+  auto browser = browser_;
   // Connect title and favicon change
   browser->connect(browser, &BrowserWidget::TitleChanged, [=]() {
     if (browser_) {
@@ -44,26 +108,7 @@ PageTreeItem::PageTreeItem(QPointer<BrowserWidget> browser,
     workspace_page_.Persist();
   });
   browser->connect(browser, &BrowserWidget::destroyed, [=]() {
-    // Mark myself invalid so I don't accidentally set myself
-    valid_ = false;
-    // If I was current, set the new current as either the prev or next
-    if (treeWidget() && (!treeWidget()->currentItem() ||
-                         treeWidget()->currentItem() == this)) {
-      static_cast<PageTree*>(treeWidget())->SetCurrentClosestTo(this);
-    }
-    // Move all the children up
-    if (parent()) {
-      parent()->insertChildren(parent()->indexOfChild(this), takeChildren());
-    } else {
-      treeWidget()->insertTopLevelItems(
-            treeWidget()->indexOfTopLevelItem(this), takeChildren());
-    }
-    if (persist_next_close_to_workspace_) {
-      workspace_page_.Delete();
-    }
-    auto workspace_item = WorkspaceItem();
-    delete this;
-    if (workspace_item) workspace_item->ChildCloseCompleted();
+    Closed();
   });
   browser->connect(browser, &BrowserWidget::AboutToShowJSDialog,
                    [=]() {
@@ -71,51 +116,34 @@ PageTreeItem::PageTreeItem(QPointer<BrowserWidget> browser,
   });
   browser->connect(browser, &BrowserWidget::CloseCancelled, [=]() {
     persist_next_close_to_workspace_ = true;
-    close_button_->setChecked(false);
+    SetCloseChecked(false);
     auto workspace_item = WorkspaceItem();
     if (workspace_item) workspace_item->ChildCloseCancelled();
   });
   browser->connect(browser, &BrowserWidget::SuspensionChanged, [=]() {
-    auto palette = QGuiApplication::palette();
-    if (browser_->Suspended()) {
-      // If it's still loading, re-apply the favicon here so
-      //  the loading movie stops
-      if (browser_->Loading()) ApplyFavicon();
-      setForeground(0, palette.brush(QPalette::Disabled, QPalette::Text));
-      auto existing_icon = icon(0);
-      auto sizes = existing_icon.availableSizes();
-      if (!sizes.isEmpty()) {
-        setIcon(0, QIcon(existing_icon.pixmap(sizes[0], QIcon::Disabled)));
-      } else {
-        setIcon(0, QIcon());
-      }
-    } else {
-      setForeground(0, palette.brush(QPalette::Active, QPalette::Text));
-      // Icon change should happen on load
-    }
+    // If it's still loading, re-apply the favicon here so
+    //  the loading movie stops
+    if (browser_->Suspended() && browser_->Loading()) ApplyFavicon();
+    ApplySuspendedLook(browser_->Suspended());
     workspace_page_.SetSuspended(browser_->Suspended());
     workspace_page_.Persist();
   });
   browser->connect(browser, &BrowserWidget::BubbleMaybeChanged, [=]() {
-    auto label = qobject_cast<QLabel*>(
-          treeWidget()->itemWidget(this, kBubbleIconColumn));
-    if (label) {
-      label->setPixmap(browser_->CurrentBubble().Icon().pixmap(16, 16));
-      label->setToolTip("Bubble: " + browser_->CurrentBubble().FriendlyName());
-    }
+    ApplyBubbleIcon();
     workspace_page_.SetBubbleId(browser_->CurrentBubble().Id());
     workspace_page_.Persist();
   });
 }
 
-PageTreeItem::~PageTreeItem() {
-  if (loading_icon_frame_conn_) {
-    treeWidget()->disconnect(loading_icon_frame_conn_);
-  }
+bool PageTreeItem::CloseChecked() const {
+  return data(kCloseButtonColumn,
+              PageTreeDelegate::kButtonCheckedRole).toBool();
 }
 
-QPointer<BrowserWidget> PageTreeItem::Browser() const {
-  return valid_ ? browser_ : nullptr;
+void PageTreeItem::SetCloseChecked(bool checked) {
+  if (checked != CloseChecked()) {
+    setData(kCloseButtonColumn, PageTreeDelegate::kButtonCheckedRole, checked);
+  }
 }
 
 void PageTreeItem::AfterAdded() {
@@ -123,35 +151,16 @@ void PageTreeItem::AfterAdded() {
   auto workspace = CurrentWorkspace();
   auto par = Parent();
   if (workspace.Id() != workspace_page_.WorkspaceId() ||
-      workspace_page_.ParentId() != (par ? par->WorkspacePage().Id() : -1)) {
+      workspace_page_.ParentId() != (par ? par->WorkspacePage().Key() : -1)) {
     workspace_page_.SetWorkspaceId(workspace.Id());
-    workspace_page_.SetParentId(par ? par->WorkspacePage().Id() : -1);
+    workspace_page_.SetParentId(par ? par->WorkspacePage().Key() : -1);
     workspace_page_.Persist();
   }
 
-  auto tree = static_cast<PageTree*>(treeWidget());
   // Apply with the current icon if it's there
   ApplyFavicon(icon(0));
 
-  // Set the icon
-  auto label = new QLabel;
-  label->setAlignment(Qt::AlignCenter);
-  label->setPixmap(browser_->CurrentBubble().Icon().pixmap(16, 16));
-  label->setToolTip("Bubble: " + browser_->CurrentBubble().FriendlyName());
-  tree->setItemWidget(this, kBubbleIconColumn, label);
-  label->setContextMenuPolicy(Qt::CustomContextMenu);
-  tree->connect(label, &QLabel::customContextMenuRequested, [=]() {
-    QMenu menu;
-    tree->ApplyBubbleSelectMenu(&menu, { this });
-    menu.exec(label->mapToGlobal(label->rect().bottomLeft()));
-  });
-
-  // Create a new close button everytime because it is destroyed otherwise
-  close_button_ = new PageCloseButton(tree);
-  tree->connect(close_button_, &PageCloseButton::Released,
-                tree, &PageTree::ItemCloseRelease);
-  tree->setItemWidget(this, kCloseButtonColumn, close_button_);
-  // Gotta call it on my children too sadly
+  // Children may have moved workspaces with us
   for (int i = 0; i < childCount(); i++) {
     static_cast<PageTreeItem*>(child(i))->AfterAdded();
   }
@@ -169,25 +178,39 @@ QJsonObject PageTreeItem::DebugDump() const {
   for (int i = 0; i < childCount(); i++) {
     children.append(static_cast<PageTreeItem*>(child(i))->DebugDump());
   }
+  auto tree = treeWidget();
+  auto rect = tree->visualItemRect(this);
+  // Painted by the delegate, so we give the cell of the column
+  QRect close_rect(
+        tree->header()->sectionViewportPosition(kCloseButtonColumn),
+        rect.y(),
+        tree->columnWidth(kCloseButtonColumn),
+        rect.height());
   return {
-    { "current", treeWidget()->currentItem() == this },
+    { "current", tree->currentItem() == this },
     { "expanded", isExpanded() },
     { "text", text(0) },
-    { "rect", Util::DebugWidgetGeom(treeWidget(),
-                                    treeWidget()->visualItemRect(this)) },
+    { "rect", Util::DebugWidgetGeom(tree, rect) },
     { "browser", (browser_) ? browser_->DebugDump() : QJsonValue() },
     { "closeButton", QJsonObject({
-      { "checked", close_button_->isChecked() },
-      { "rect", Util::DebugWidgetGeom(close_button_) }
+      { "checked", CloseChecked() },
+      { "rect", Util::DebugWidgetGeom(tree, close_rect) }
     })},
     { "items", children }
   };
 }
 
 QList<PageTreeItem*> PageTreeItem::SelfAndChildren() const {
-  QList<PageTreeItem*> ret({ const_cast<PageTreeItem*>(this) });
-  for (int i = 0; i < childCount(); i++) {
-    ret << static_cast<PageTreeItem*>(child(i))->SelfAndChildren();
+  // Depth first w/ a stack instead of merging lists for each level
+  QList<PageTreeItem*> ret;
+  QStack<PageTreeItem*> stack;
+  stack.push(const_cast<PageTreeItem*>(this));
+  while (!stack.isEmpty()) {
+    auto item = stack.pop();
+    ret.append(item);
+    for (int i = item->childCount() - 1; i >= 0; i--) {
+      stack.push(static_cast<PageTreeItem*>(item->child(i)));
+    }
   }
   return ret;
 }
@@ -264,11 +287,23 @@ QList<PageTreeItem*> PageTreeItem::Siblings() const {
 
 void PageTreeItem::SetCurrentBubbleIfDifferent(const Bubble& bubble) {
   // Only change if the name is different
-  if (bubble.Name() != browser_->CurrentBubble().Name()) {
+  if (bubble.Name() == CurrentBubble().Name()) return;
+  if (browser_) {
     browser_->ChangeCurrentBubble(bubble);
+  } else {
+    // Nothing is loaded, so it's just what it'll use when it is
+    workspace_page_.SetBubbleId(bubble.Id());
+    workspace_page_.Persist();
+    ApplyBubbleIcon();
   }
 }
 
+void PageTreeItem::SetPos(int pos) {
+  if (workspace_page_.Pos() == pos) return;
+  workspace_page_.SetPos(pos);
+  workspace_page_.Persist();
+}
+
 const Workspace& PageTreeItem::CurrentWorkspace() {
   auto item = WorkspaceItem();
   if (item) return item->CurrentWorkspace();
@@ -291,21 +326,63 @@ void PageTreeItem::CollapseStateChanged() {
   }
 }
 
+void PageTreeItem::ApplySuspendedLook(bool suspended) {
+  auto palette = QGuiApplication::palette();
+  if (suspended) {
+    setForeground(0, palette.brush(QPalette::Disabled, QPalette::Text));
+    auto existing_icon = icon(0);
+    auto sizes = existing_icon.availableSizes();
+    if (!sizes.isEmpty()) {
+      setIcon(0, QIcon(existing_icon.pixmap(sizes[0], QIcon::Disabled)));
+    } else {
+      setIcon(0, QIcon());
+    }
+  } else {
+    setForeground(0, palette.brush(QPalette::Active, QPalette::Text));
+    // Icon change should happen on load
+  }
+}
+
+void PageTreeItem::ApplyBubbleIcon() {
+  auto bubble = CurrentBubble();
+  setIcon(kBubbleIconColumn, bubble.Icon());
+  setToolTip(kBubbleIconColumn, "Bubble: " + bubble.FriendlyName());
+}
+
+void PageTreeItem::Closed() {
+  // Mark myself invalid so I don't accidentally set myself
+  valid_ = false;
+  if (browser_) browser_->SetScreenshotIdLookup(nullptr);
+  // If I was current, set the new current as either the prev or next
+  if (treeWidget() && (!treeWidget()->currentItem() ||
+                       treeWidget()->currentItem() == this)) {
+    static_cast<PageTree*>(treeWidget())->SetCurrentClosestTo(this);
+  }
+  // Move all the children up
+  if (parent()) {
+    parent()->insertChildren(parent()->indexOfChild(this), takeChildren());
+  } else {
+    treeWidget()->insertTopLevelItems(
+          treeWidget()->indexOfTopLevelItem(this), takeChildren());
+  }
+  if (persist_next_close_to_workspace_) {
+    // One is only stored once the ID is looked up, so don't wait for it
+    ScreenshotCache::Remove(workspace_page_.KnownId());
+    workspace_page_.Delete();
+  }
+  auto workspace_item = WorkspaceItem();
+  emit static_cast<PageTree*>(treeWidget())->ItemDestroyed(this);
+  delete this;
+  if (workspace_item) workspace_item->ChildCloseCompleted();
+}
+
 void PageTreeItem::ApplyFavicon(const QIcon& icon_override) {
   auto tree = static_cast<PageTree*>(treeWidget());
-  if (loading_icon_frame_conn_) tree->disconnect(loading_icon_frame_conn_);
   if (browser_) {
-    if (browser_->Loading() && !browser_->Suspended()) {
-      tree->LoadingIconMovie()->start();
-      // We don't like constantly setting the icon here, but there's not
-      // a much better option. Putting a QMovie as a setItemWidget has other
-      // display problems and I'm too lazy to create an item delegate.
-      loading_icon_frame_conn_ = tree->connect(tree->LoadingIconMovie(),
-                                               &QMovie::frameChanged,
-                                               [this, tree](int) {
-        setIcon(0, QIcon(tree->LoadingIconMovie()->currentPixmap()));
-      });
-    } else {
+    // The delegate draws the animation, we just flag it
+    auto loading = browser_->Loading() && !browser_->Suspended();
+    tree->SetItemLoading(this, loading);
+    if (!loading) {
       auto icon = icon_override.isNull() ?
             browser_->CurrentFavicon() : icon_override;
       // Only update if an icon is not already set
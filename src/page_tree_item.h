@@ -4,7 +4,6 @@
 #include <QtWidgets>
 
 #include "browser_widget.h"
-#include "page_close_button.h"
 #include "workspace.h"
 #include "workspace_tree_item.h"
 
@@ -16,11 +15,30 @@ class PageTreeItem : public QTreeWidgetItem {
   static const int kBubbleIconColumn = 1;
   static const int kCloseButtonColumn = 2;
 
+  // A null browser makes this a placeholder for a suspended page until
+  //  PageTree::MaterializeItem gives it one
   explicit PageTreeItem(QPointer<BrowserWidget> browser,
                         const Workspace::WorkspacePage& workspace_page);
-  ~PageTreeItem();
+  // Null for placeholders
   QPointer<BrowserWidget> Browser() const;
-  PageCloseButton* CloseButton() const { return close_button_; }
+  void SetBrowser(QPointer<BrowserWidget> browser);
+  // Lets the browser look up this page's ID for its screenshot until this
+  //  is closed. Done by SetBrowser, but can be done before it.
+  void ProvideScreenshotId(BrowserWidget* browser);
+  bool Placeholder() const { return valid_ && !browser_; }
+  // Just marks the page suspended, there's nothing loaded to stop
+  void SuspendPlaceholder();
+
+  // These work for placeholders too, from the workspace page
+  QString CurrentUrl() const;
+  Bubble CurrentBubble() const;
+  bool Suspended() const;
+  // Placeholders are just removed, there's nothing to ask
+  void TryClose();
+
+  // Close button pressed or dragged over, but not yet released
+  bool CloseChecked() const;
+  void SetCloseChecked(bool checked);
   void AfterAdded();
 
   PageTreeItem* Parent() const;
@@ -43,6 +61,9 @@ class PageTreeItem : public QTreeWidgetItem {
 
   void SetCurrentBubbleIfDifferent(const Bubble& bubble);
 
+  // Position among its siblings
+  void SetPos(int pos);
+
   void SetPersistNextCloseToWorkspace(bool persist) {
     persist_next_close_to_workspace_ = persist;
   }
@@ -55,12 +76,14 @@ class PageTreeItem : public QTreeWidgetItem {
   bool Valid() const { return valid_; }
 
  private:
+  void ConnectBrowser();
   void ApplyFavicon(const QIcon& icon_override = QIcon());
+  void ApplySuspendedLook(bool suspended);
+  void ApplyBubbleIcon();
+  void Closed();
 
   QPointer<BrowserWidget> browser_;
   Workspace::WorkspacePage workspace_page_;
-  PageCloseButton* close_button_ = nullptr;
-  QMetaObject::Connection loading_icon_frame_conn_;
   bool persist_next_close_to_workspace_ = true;
   bool valid_ = true;
 };
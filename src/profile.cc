@@ -4,7 +4,10 @@
 
 #include "action_manager.h"
 #include "bubble.h"
+#include "page_index.h"
 #include "sql.h"
+#include "sql_executor.h"
+#include "startup_profile.h"
 #include "util.h"
 #include "workspace.h"
 
@@ -354,8 +357,18 @@ bool Profile::SetCurrent(const Profile& profile) {
     qCritical() << "Unable to open doogie.db";
     return false;
   }
-  if (!Sql::EnsureDatabaseSchema()) {
-    qCritical() << "Unable to ensure schema is created";
+  {
+    // Only unapplied versions are run, so this is just a pragma read
+    //  on every start after the first
+    StartupProfile::PhaseTimer schema_phase("schema");
+    // Decayed frecency needs pow, which SQLite doesn't have
+    if (!Sql::EnsureDatabaseSchema({ { 4, &PageIndex::SeedFrecency } })) {
+      qCritical() << "Unable to ensure schema is created";
+      return false;
+    }
+  }
+  if (!SqlExecutor::Start()) {
+    qCritical() << "Unable to start DB writer";
     return false;
   }
 
@@ -0,0 +1,59 @@
+#include "screenshot_cache.h"
+
+#include "profile.h"
+
+namespace doogie {
+
+QCache<qlonglong, QPixmap>* ScreenshotCache::pixmaps_ = nullptr;
+
+void ScreenshotCache::Store(qlonglong page_id, const QPixmap& screenshot) {
+  if (page_id < 0 || screenshot.isNull()) return;
+  auto pixmap = screenshot;
+  if (pixmap.width() > kMaxStoredWidth) {
+    pixmap = pixmap.scaledToWidth(kMaxStoredWidth, Qt::SmoothTransformation);
+  }
+  CacheDecoded(page_id, pixmap);
+  auto path = FilePath(page_id);
+  if (path.isEmpty()) return;
+  QDir().mkpath(QFileInfo(path).path());
+  if (!pixmap.save(path, "JPG", kJpegQuality)) {
+    qWarning() << "Unable to save suspended screenshot to" << path;
+  }
+}
+
+QPixmap ScreenshotCache::Load(qlonglong page_id) {
+  if (page_id < 0) return QPixmap();
+  if (pixmaps_) {
+    auto cached = pixmaps_->object(page_id);
+    if (cached) return *cached;
+  }
+  auto path = FilePath(page_id);
+  if (path.isEmpty() || !QFile::exists(path)) return QPixmap();
+  QPixmap pixmap;
+  if (!pixmap.load(path, "JPG")) return QPixmap();
+  CacheDecoded(page_id, pixmap);
+  return pixmap;
+}
+
+void ScreenshotCache::Remove(qlonglong page_id) {
+  if (page_id < 0) return;
+  if (pixmaps_) pixmaps_->remove(page_id);
+  auto path = FilePath(page_id);
+  if (!path.isEmpty()) QFile::remove(path);
+}
+
+QString ScreenshotCache::FilePath(qlonglong page_id) {
+  if (Profile::Current().InMemory()) return QString();
+  return QDir(Profile::Current().Path()).filePath(
+        QString("suspended_screenshots/%1.jpg").arg(page_id));
+}
+
+void ScreenshotCache::CacheDecoded(qlonglong page_id, const QPixmap& pixmap) {
+  if (!pixmaps_) pixmaps_ = new QCache<qlonglong, QPixmap>(kMemoryCacheKb);
+  auto cost = pixmap.width() * pixmap.height() * pixmap.depth() / 8 / 1024;
+  pixmaps_->insert(page_id, new QPixmap(pixmap), qMax(1, cost));
+}
+
+ScreenshotCache::ScreenshotCache() { }
+
+}  // namespace doogie
@@ -0,0 +1,39 @@
+#ifndef DOOGIE_SCREENSHOT_CACHE_H_
+#define DOOGIE_SCREENSHOT_CACHE_H_
+
+#include <QtWidgets>
+
+namespace doogie {
+
+// Screenshots of suspended pages keyed by workspace page ID. They are kept
+// as small JPEGs in the profile dir so a suspended page costs nothing in
+// memory until it's shown. Only a few decoded ones are kept around. For
+// in-memory profiles there is nowhere to put them, so they only live in
+// the decoded cache until they fall out. Must be used on the GUI thread.
+class ScreenshotCache {
+ public:
+  // Max decoded screenshots to keep in memory, in KB
+  static const int kMemoryCacheKb = 32 * 1024;
+  static const int kJpegQuality = 70;
+  // Stored no wider than this, they're scaled back up when shown
+  static const int kMaxStoredWidth = 1280;
+
+  static void Store(qlonglong page_id, const QPixmap& screenshot);
+  // Null if there isn't one
+  static QPixmap Load(qlonglong page_id);
+  static void Remove(qlonglong page_id);
+
+ private:
+  // Empty if in-memory profile
+  static QString FilePath(qlonglong page_id);
+  static void CacheDecoded(qlonglong page_id, const QPixmap& pixmap);
+
+  // Created lazily and never freed since pixmaps can't outlive the app
+  static QCache<qlonglong, QPixmap>* pixmaps_;
+
+  ScreenshotCache();
+};
+
+}  // namespace doogie
+
+#endif  // DOOGIE_SCREENSHOT_CACHE_H_
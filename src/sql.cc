@@ -1,5 +1,8 @@
 #include "sql.h"
 
+#include "metrics_registry.h"
+#include "tracing.h"
+
 namespace doogie {
 
 // Easy on/off for debugging
@@ -12,16 +15,31 @@ const bool kSqlLoggingEnabled = false;
 const QLoggingCategory Sql::kLoggingCat(
     "sql", kSqlLoggingEnabled ? QtDebugMsg : QtInfoMsg);
 
-bool Sql::EnsureDatabaseSchema() {
-  QFile file(":/res/schema.sql");
-  if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-    qCritical() << "Unable to read schema resource";
-    return false;
-  }
-  auto schema = QString::fromUtf8(file.readAll());
+bool Sql::EnsureDatabaseSchema(
+    const QHash<int, MigrationHook>& after_version) {
   QSqlQuery query;
-  for (auto stmt : schema.split("\n\n")) {
-    if (!Exec(&query, stmt)) return false;
+  auto rec = ExecSingle(&query, "PRAGMA user_version");
+  if (rec.isEmpty()) return false;
+  auto curr_version = rec.value(0).toInt();
+  query.finish();
+  // Unversioned DBs, new or old, get the base schema which is written to
+  //  be safe to run again
+  auto db = QSqlDatabase::database();
+  for (int version = curr_version + 1;
+       version <= kSchemaVersion;
+       version++) {
+    auto res_name = version == 1 ? QString(":/res/schema.sql") :
+        QString(":/res/migrations/%1.sql").arg(version);
+    db.transaction();
+    if (!ExecScript(&query, res_name) ||
+        (after_version.contains(version) &&
+            !after_version[version](&query)) ||
+        !Exec(&query, QString("PRAGMA user_version = %1").arg(version))) {
+      qCritical() << "Unable to apply schema version" << version;
+      db.rollback();
+      return false;
+    }
+    if (!db.commit()) return false;
   }
   return true;
 }
@@ -79,20 +97,18 @@ bool Sql::Prepare(QSqlQuery* query, const QString& sql) {
 }
 
 bool Sql::Exec(QSqlQuery* query) {
-  if (!query->exec()) {
-    qCritical() << "Failed to exec query: " << query->lastError().text();
-    return false;
-  }
-  return true;
+  static auto exec_time = MetricsRegistry::GetHistogram("sql.exec");
+  MetricsRegistry::ScopedTimer timer(exec_time);
+  Tracing::Span span("sql", "Exec", query->lastQuery());
+  return query->exec() || ExecFailed(query);
 }
 
 bool Sql::Exec(QSqlQuery* query, const QString& sql) {
   DebugLog() << "Executing " << sql;
-  if (!query->exec(sql)) {
-    qCritical() << "Failed to exec query: " << query->lastError().text();
-    return false;
-  }
-  return true;
+  static auto exec_time = MetricsRegistry::GetHistogram("sql.exec");
+  MetricsRegistry::ScopedTimer timer(exec_time);
+  Tracing::Span span("sql", "Exec", sql);
+  return query->exec(sql) || ExecFailed(query);
 }
 
 QSqlRecord Sql::ExecSingle(QSqlQuery* query, const QString& sql) {
@@ -104,6 +120,34 @@ QSqlRecord Sql::ExecSingle(QSqlQuery* query, const QString& sql) {
   return query->record();
 }
 
+bool Sql::ExecFailed(QSqlQuery* query) {
+  static auto errors = MetricsRegistry::GetCounter("sql.errors");
+  errors->Increment();
+  qCritical() << "Failed to exec query: " << query->lastError().text();
+  return false;
+}
+
+bool Sql::ExecScript(QSqlQuery* query, const QString& res_name) {
+  QFile file(res_name);
+  if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    qCritical() << "Unable to read schema resource" << res_name;
+    return false;
+  }
+  auto script = QString::fromUtf8(file.readAll());
+  for (auto stmt : script.split("\n\n")) {
+    if (HasStatement(stmt) && !Exec(query, stmt)) return false;
+  }
+  return true;
+}
+
+bool Sql::HasStatement(const QString& chunk) {
+  for (const auto& line : chunk.split('\n')) {
+    auto trimmed = line.trimmed();
+    if (!trimmed.isEmpty() && !trimmed.startsWith("--")) return true;
+  }
+  return false;
+}
+
 Sql::Sql() { }
 
 }  // namespace doogie
@@ -3,13 +3,24 @@
 
 #include <QtSql>
 #include <QtWidgets>
+#include <functional>
 
 namespace doogie {
 
 // Abstraction over Qt's SQL features.
 class Sql {
  public:
-  static bool EnsureDatabaseSchema();
+  // Version 1 is schema.sql, every version after is migrations/<n>.sql
+  static const int kSchemaVersion = 5;
+
+  // For migrations that can't be done in SQL alone
+  typedef std::function<bool(QSqlQuery* query)> MigrationHook;
+
+  // The hooks are keyed by the version they are run after, in the same
+  //  transaction as its script
+  static bool EnsureDatabaseSchema(
+      const QHash<int, MigrationHook>& after_version =
+          QHash<int, MigrationHook>());
 
   static QSqlRecord ExecSingleParam(QSqlQuery* query,
                                     const QString& sql,
@@ -35,6 +46,12 @@ class Sql {
 
   static QDebug DebugLog() { return qDebug(kLoggingCat).noquote(); }
 
+  static bool ExecScript(QSqlQuery* query, const QString& res_name);
+  // Comment-only chunks compile to no statement, which fails to exec
+  static bool HasStatement(const QString& chunk);
+  // Logs and counts it, always false
+  static bool ExecFailed(QSqlQuery* query);
+
   Sql();
 };
 
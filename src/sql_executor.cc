@@ -0,0 +1,237 @@
+#include "sql_executor.h"
+
+#include "sql.h"
+
+namespace doogie {
+
+const QString SqlExecutor::kConnectionName = "doogie_writer";
+SqlExecutor* SqlExecutor::instance_ = nullptr;
+std::atomic<qlonglong> SqlExecutor::next_key_ { -2 };
+QMutex SqlExecutor::keys_mutex_;
+QHash<qlonglong, qlonglong> SqlExecutor::ids_by_key_;
+
+bool SqlExecutor::Start() {
+  Stop();
+  auto db = QSqlDatabase::database();
+  if (!db.isOpen()) return false;
+  // Nothing to share an in-mem DB with, we just run inline
+  if (db.databaseName() == ":memory:") return true;
+  // WAL lets the default connection keep reading while we write, and
+  // both sides wait on each other instead of failing with SQLITE_BUSY
+  QSqlQuery query(db);
+  if (!Sql::Exec(&query, "PRAGMA journal_mode = WAL") ||
+      !Sql::Exec(&query, "PRAGMA busy_timeout = 5000")) {
+    return false;
+  }
+  instance_ = new SqlExecutor(db.databaseName());
+  instance_->start();
+  return true;
+}
+
+void SqlExecutor::Stop() {
+  if (!instance_) return;
+  {
+    QMutexLocker locker(&instance_->mutex_);
+    instance_->stopping_ = true;
+    instance_->has_work_.wakeAll();
+  }
+  instance_->wait();
+  delete instance_;
+  instance_ = nullptr;
+}
+
+SqlExecutor::Result SqlExecutor::Enqueue(Operation op,
+                                         const QStringList& tables) {
+  if (!instance_) return RunInline(op);
+  QMutexLocker locker(&instance_->mutex_);
+  // Everything queued before is written by now, so order is kept
+  if (instance_->stopped_) {
+    locker.unlock();
+    return RunInline(op);
+  }
+  Pending pending { op, std::make_shared<std::promise<QVariant>>() };
+  Result ret = pending.promise->get_future().share();
+  instance_->queue_.enqueue(pending);
+  for (const auto& table : tables) instance_->last_by_table_[table] = ret;
+  QueueDepth()->Set(instance_->queue_.size());
+  instance_->has_work_.wakeAll();
+  return ret;
+}
+
+SqlExecutor::Result SqlExecutor::EnqueueParam(const QString& sql,
+                                              QVariantList params,
+                                              const QStringList& tables) {
+  return Enqueue([=](QSqlQuery* query) -> QVariant {
+    if (!Sql::ExecParam(query, sql, params)) return QVariant();
+    return query->lastInsertId();
+  }, tables);
+}
+
+void SqlExecutor::Flush() {
+  if (!instance_) return;
+  QMutexLocker locker(&instance_->mutex_);
+  while (!instance_->queue_.isEmpty() || instance_->busy_) {
+    instance_->drained_.wait(&instance_->mutex_);
+  }
+}
+
+void SqlExecutor::WaitFor(const QString& table) {
+  if (!instance_) return;
+  Result last;
+  {
+    QMutexLocker locker(&instance_->mutex_);
+    last = instance_->last_by_table_.value(table);
+  }
+  if (last.valid()) last.wait();
+}
+
+qlonglong SqlExecutor::NewKey() {
+  return next_key_.fetch_sub(1);
+}
+
+void SqlExecutor::MapKey(qlonglong key, qlonglong id) {
+  if (instance_ && QThread::currentThread() == instance_) {
+    instance_->batch_ids_by_key_[key] = id;
+    return;
+  }
+  // Inline, so already committed
+  QMutexLocker locker(&keys_mutex_);
+  ids_by_key_[key] = id;
+}
+
+qlonglong SqlExecutor::ResolveKey(qlonglong key_or_id) {
+  if (key_or_id >= -1) return key_or_id;
+  if (instance_ && QThread::currentThread() == instance_) {
+    auto id = instance_->batch_ids_by_key_.value(key_or_id, -1);
+    if (id >= 0) return id;
+  }
+  QMutexLocker locker(&keys_mutex_);
+  return ids_by_key_.value(key_or_id, -1);
+}
+
+void SqlExecutor::AfterCommit(std::function<void()> callback) {
+  if (instance_ && QThread::currentThread() == instance_) {
+    instance_->after_commit_.append(callback);
+  } else {
+    // Inline, so already committed
+    callback();
+  }
+}
+
+void SqlExecutor::ForgetKey(qlonglong key) {
+  if (key >= -1) return;
+  Enqueue([=](QSqlQuery*) -> QVariant {
+    QMutexLocker locker(&keys_mutex_);
+    ids_by_key_.remove(key);
+    return true;
+  });
+}
+
+SqlExecutor::~SqlExecutor() {
+  // Just in case someone deletes us w/out Stop
+  {
+    QMutexLocker locker(&mutex_);
+    stopping_ = true;
+    has_work_.wakeAll();
+  }
+  wait();
+}
+
+void SqlExecutor::run() {
+  {
+    auto db = QSqlDatabase::addDatabase("QSQLITE", kConnectionName);
+    db.setDatabaseName(db_name_);
+    if (!db.open()) {
+      qCritical() << "Unable to open writer connection: " <<
+                     db.lastError().text();
+    } else {
+      QSqlQuery query(db);
+      Sql::Exec(&query, "PRAGMA busy_timeout = 5000");
+    }
+    static auto batch_time = MetricsRegistry::GetHistogram("sql.writer.batch");
+    static auto ops = MetricsRegistry::GetCounter("sql.writer.ops");
+    forever {
+      QQueue<Pending> batch;
+      {
+        QMutexLocker locker(&mutex_);
+        while (queue_.isEmpty() && !stopping_) has_work_.wait(&mutex_);
+        if (queue_.isEmpty()) {
+          stopped_ = true;
+          break;
+        }
+        batch.swap(queue_);
+        QueueDepth()->Set(0);
+        busy_ = true;
+      }
+      {
+        MetricsRegistry::ScopedTimer timer(batch_time);
+        RunBatch(&db, batch);
+      }
+      ops->Increment(batch.size());
+      {
+        QMutexLocker locker(&mutex_);
+        busy_ = false;
+        // Nothing left to wait for on these
+        for (auto it = last_by_table_.begin(); it != last_by_table_.end();) {
+          if (it->wait_for(std::chrono::seconds(0)) ==
+              std::future_status::ready) {
+            it = last_by_table_.erase(it);
+          } else {
+            it++;
+          }
+        }
+        drained_.wakeAll();
+      }
+    }
+    db.close();
+  }
+  QSqlDatabase::removeDatabase(kConnectionName);
+}
+
+MetricsRegistry::Gauge* SqlExecutor::QueueDepth() {
+  static auto gauge = MetricsRegistry::GetGauge("sql.writer.queueDepth");
+  return gauge;
+}
+
+SqlExecutor::Result SqlExecutor::RunInline(Operation op) {
+  std::promise<QVariant> promise;
+  QSqlQuery query;
+  promise.set_value(op(&query));
+  return promise.get_future().share();
+}
+
+SqlExecutor::SqlExecutor(const QString& db_name) : db_name_(db_name) { }
+
+void SqlExecutor::RunBatch(QSqlDatabase* db, const QQueue<Pending>& batch) {
+  QVariantList results;
+  results.reserve(batch.size());
+  if (db->isOpen()) {
+    // We accept that one failed op doesn't roll back the others, they
+    // are all independent of each other
+    auto in_tx = db->transaction();
+    QSqlQuery query(*db);
+    for (const auto& pending : batch) results.append(pending.op(&query));
+    if (in_tx && !db->commit()) {
+      qCritical() << "Failed to commit writes: " << db->lastError().text();
+      db->rollback();
+      results.clear();
+    } else {
+      // Only now can other batches (and readers) rely on them
+      QMutexLocker locker(&keys_mutex_);
+      for (auto it = batch_ids_by_key_.constBegin();
+           it != batch_ids_by_key_.constEnd(); it++) {
+        ids_by_key_[it.key()] = it.value();
+      }
+      locker.unlock();
+      for (const auto& callback : after_commit_) callback();
+    }
+    batch_ids_by_key_.clear();
+    after_commit_.clear();
+  }
+  // Only resolve after commit so readers can see what was written
+  for (int i = 0; i < batch.size(); i++) {
+    batch[i].promise->set_value(i < results.size() ? results[i] : QVariant());
+  }
+}
+
+}  // namespace doogie
@@ -0,0 +1,113 @@
+#ifndef DOOGIE_SQL_EXECUTOR_H_
+#define DOOGIE_SQL_EXECUTOR_H_
+
+#include <QtSql>
+#include <QtWidgets>
+
+#include <atomic>
+#include <functional>
+#include <future>
+#include <memory>
+
+#include "metrics_registry.h"
+
+namespace doogie {
+
+// Background writer for the profile DB. It owns its own SQLite
+// connection on its own thread, and every write handed to it is
+// queued. Everything queued while a previous batch was being written
+// is run together in a single transaction. When no writer is running
+// (e.g. in-memory profiles or after shutdown), operations run inline
+// on the default connection.
+class SqlExecutor : public QThread {
+ public:
+  // Run on the writer thread w/ a query bound to the writer connection.
+  // The returned value is what the future resolves to (usually the last
+  // insert ID). An invalid QVariant is the convention for failure.
+  typedef std::function<QVariant(QSqlQuery* query)> Operation;
+  typedef std::shared_future<QVariant> Result;
+
+  // Starts a writer against the same DB as the default connection.
+  // Does nothing (i.e. stays inline) for in-memory DBs.
+  static bool Start();
+  // Writes everything still queued and stops the writer. Anything queued
+  //  while it's stopping is still written by it, in order.
+  static void Stop();
+
+  // The tables are the ones written to, so WaitFor knows what to wait on
+  static Result Enqueue(Operation op,
+                        const QStringList& tables = QStringList());
+  // Shortcut for a single statement, resolves to the last insert ID
+  static Result EnqueueParam(const QString& sql,
+                             QVariantList params,
+                             const QStringList& tables = QStringList());
+  // Blocks until everything queued so far is committed
+  static void Flush();
+  // Blocks until the last write queued so far for the table is committed.
+  // Readers on the default connection should call this when they need to
+  // see their own writes, it doesn't wait on anything queued after.
+  static void WaitFor(const QString& table);
+
+  // Rows inserted through the writer can be referred to by a key before
+  // the insert is done so nothing has to wait on it. Keys are always less
+  // than -1. The insert op calls MapKey w/ the new row ID and later ops
+  // call ResolveKey to get it. Once the ID is known to the holders of the
+  // key, they call ForgetKey.
+  static qlonglong NewKey();
+  // Only from ops. Other batches only see it once this one commits, and
+  //  never if it rolls back.
+  static void MapKey(qlonglong key, qlonglong id);
+  // Only from ops. IDs are given back as is, unknown keys are -1.
+  static qlonglong ResolveKey(qlonglong key_or_id);
+  // Only from ops. Run on the writer once the op's batch commits, or never
+  //  if it rolls back. For caching what was written.
+  static void AfterCommit(std::function<void()> callback);
+  // Dropped after everything queued so far, so only once nothing queued
+  //  later will refer to it
+  static void ForgetKey(qlonglong key);
+
+  ~SqlExecutor();
+
+ protected:
+  void run() override;
+
+ private:
+  static const QString kConnectionName;
+
+  struct Pending {
+    Operation op;
+    std::shared_ptr<std::promise<QVariant>> promise;
+  };
+
+  static MetricsRegistry::Gauge* QueueDepth();
+  static Result RunInline(Operation op);
+
+  explicit SqlExecutor(const QString& db_name);
+
+  void RunBatch(QSqlDatabase* db, const QQueue<Pending>& batch);
+
+  static SqlExecutor* instance_;
+  static std::atomic<qlonglong> next_key_;
+  static QMutex keys_mutex_;
+  static QHash<qlonglong, qlonglong> ids_by_key_;
+
+  QString db_name_;
+  QMutex mutex_;
+  QWaitCondition has_work_;
+  QWaitCondition drained_;
+  QQueue<Pending> queue_;
+  // Only the ones not written yet
+  QHash<QString, Result> last_by_table_;
+  // Only touched by the writer, moved to ids_by_key_ on commit
+  QHash<qlonglong, qlonglong> batch_ids_by_key_;
+  // Only touched by the writer, run and cleared on commit
+  QList<std::function<void()>> after_commit_;
+  bool busy_ = false;
+  bool stopping_ = false;
+  // Set by the writer once it's done w/ the queue for good
+  bool stopped_ = false;
+};
+
+}  // namespace doogie
+
+#endif  // DOOGIE_SQL_EXECUTOR_H_
@@ -0,0 +1,84 @@
+#include "startup_profile.h"
+
+#include <algorithm>
+
+#include "metrics_registry.h"
+
+namespace doogie {
+
+QElapsedTimer StartupProfile::clock_;
+QList<StartupProfile::Phase> StartupProfile::phases_;
+qint64 StartupProfile::total_ms_ = -1;
+
+StartupProfile::PhaseTimer::PhaseTimer(const char* name) : name_(name) {
+  if (Finished()) return;
+  start_ms_ = NowMs();
+  span_.reset(new Tracing::Span("startup", name));
+}
+
+StartupProfile::PhaseTimer::~PhaseTimer() {
+  End();
+}
+
+void StartupProfile::PhaseTimer::End() {
+  if (start_ms_ < 0) return;
+  span_.reset();
+  Phase phase { QString::fromLatin1(name_), start_ms_, NowMs() - start_ms_ };
+  start_ms_ = -1;
+  // Startup could have finished w/ us still running, we still want it
+  phases_.append(phase);
+  MetricsRegistry::GetGauge(QString("startup.%1Ms").arg(phase.name))->
+      Set(phase.elapsed_ms);
+  qInfo() << "Startup phase" << phase.name << "took" <<
+             phase.elapsed_ms << "ms";
+}
+
+void StartupProfile::Begin() {
+  if (!clock_.isValid()) clock_.start();
+}
+
+void StartupProfile::Finish() {
+  if (Finished()) return;
+  total_ms_ = NowMs();
+  MetricsRegistry::GetGauge("startup.totalMs")->Set(total_ms_);
+  qInfo() << "Startup took" << total_ms_ << "ms";
+}
+
+bool StartupProfile::FastStart() {
+  return QSettings().value("startup/fastStart", true).toBool();
+}
+
+QList<StartupProfile::Phase> StartupProfile::Phases() {
+  auto ret = phases_;
+  // They're added as they end, so nested ones come before their parents
+  std::stable_sort(ret.begin(), ret.end(),
+                   [](const Phase& a, const Phase& b) {
+    return a.start_ms < b.start_ms;
+  });
+  return ret;
+}
+
+QString StartupProfile::Summary() {
+  QString ret;
+  for (const auto& phase : Phases()) {
+    ret += QString("%1: %2 ms (at %3 ms)\n").
+        arg(phase.name).arg(phase.elapsed_ms).arg(phase.start_ms);
+  }
+  if (Finished()) {
+    ret += QString("Total: %1 ms").arg(total_ms_);
+  } else {
+    ret += "Still starting";
+  }
+  if (!FastStart()) ret += "\n(fast start is off)";
+  return ret;
+}
+
+qint64 StartupProfile::NowMs() {
+  // In case Begin wasn't called, we at least time from here
+  Begin();
+  return clock_.elapsed();
+}
+
+StartupProfile::StartupProfile() { }
+
+}  // namespace doogie
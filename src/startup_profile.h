@@ -0,0 +1,70 @@
+#ifndef DOOGIE_STARTUP_PROFILE_H_
+#define DOOGIE_STARTUP_PROFILE_H_
+
+#include <QtWidgets>
+
+#include <memory>
+
+#include "tracing.h"
+
+namespace doogie {
+
+// Times the phases of startup, from the top of main until the event loop
+// first turns after the window is shown. Each phase is logged, traced if
+// recording, and kept as a "startup.<phase>Ms" metrics gauge so a slow
+// start can be looked at after the fact. All calls must be on the GUI
+// thread (or the main thread before the app exists).
+class StartupProfile {
+ public:
+  struct Phase {
+    QString name;
+    qint64 start_ms;
+    qint64 elapsed_ms;
+  };
+
+  // Times from construction until End or destruction. The name must be a
+  //  literal. Does nothing once startup is finished.
+  class PhaseTimer {
+   public:
+    explicit PhaseTimer(const char* name);
+    ~PhaseTimer();
+    void End();
+
+   private:
+    const char* name_;
+    // Negative when not timing
+    qint64 start_ms_ = -1;
+    std::unique_ptr<Tracing::Span> span_;
+    Q_DISABLE_COPY(PhaseTimer)
+  };
+
+  // Should be the first thing main does
+  static void Begin();
+  // Called once the window is up, later calls are ignored
+  static void Finish();
+  static bool Finished() { return total_ms_ >= 0; }
+
+  // When set (the default), work not needed to show the window is put
+  //  off until it is, e.g. hidden docks fill themselves on first show
+  static bool FastStart();
+
+  // In start order
+  static QList<Phase> Phases();
+  // Negative if not finished
+  static qint64 TotalMs() { return total_ms_; }
+  // Human readable, one phase per line
+  static QString Summary();
+
+ private:
+  static qint64 NowMs();
+
+  static QElapsedTimer clock_;
+  static QList<Phase> phases_;
+  static qint64 total_ms_;
+
+  StartupProfile();
+};
+
+}  // namespace doogie
+
+#endif  // DOOGIE_STARTUP_PROFILE_H_
@@ -0,0 +1,31 @@
+#include "suspended_page_view.h"
+
+#include "screenshot_cache.h"
+
+namespace doogie {
+
+SuspendedPageView::SuspendedPageView(qlonglong page_id, QWidget* parent)
+    : QWidget(parent), page_id_(page_id) { }
+
+void SuspendedPageView::paintEvent(QPaintEvent*) {
+  QPainter painter(this);
+  painter.fillRect(rect(), palette().window());
+  auto screenshot = ScreenshotCache::Load(page_id_);
+  if (!screenshot.isNull()) {
+    // Lighter to look disabled, and back to the width it was taken at
+    painter.setOpacity(0.2);
+    painter.setRenderHint(QPainter::SmoothPixmapTransform);
+    painter.drawPixmap(
+          QRect(0, 0, width(),
+                screenshot.height() * width() / screenshot.width()),
+          screenshot);
+    painter.setOpacity(1.0);
+  }
+  auto font = painter.font();
+  font.setPointSize(40);
+  font.setBold(true);
+  painter.setFont(font);
+  painter.drawText(rect(), Qt::AlignCenter, "Suspended");
+}
+
+}  // namespace doogie
@@ -0,0 +1,25 @@
+#ifndef DOOGIE_SUSPENDED_PAGE_VIEW_H_
+#define DOOGIE_SUSPENDED_PAGE_VIEW_H_
+
+#include <QtWidgets>
+
+namespace doogie {
+
+// Shown in place of the browser of a suspended page. It paints the page's
+// last screenshot, lightened, only fetching it when actually painted.
+class SuspendedPageView : public QWidget {
+  Q_OBJECT
+
+ public:
+  explicit SuspendedPageView(qlonglong page_id, QWidget* parent = nullptr);
+
+ protected:
+  void paintEvent(QPaintEvent* event) override;
+
+ private:
+  qlonglong page_id_;
+};
+
+}  // namespace doogie
+
+#endif  // DOOGIE_SUSPENDED_PAGE_VIEW_H_
@@ -0,0 +1,146 @@
+#include "suspension_policy.h"
+
+#include <algorithm>
+
+#include "metrics_registry.h"
+#include "page_tree.h"
+#include "util.h"
+
+namespace doogie {
+
+SuspensionPolicy::SuspensionPolicy(PageTree* tree)
+    : QObject(tree), tree_(tree) {
+  started_ = QDateTime::currentMSecsSinceEpoch();
+  connect(tree, &PageTree::ItemDestroyed, [=](PageTreeItem* item) {
+    last_active_.remove(item);
+  });
+  connect(&timer_, &QTimer::timeout, this, &SuspensionPolicy::Check);
+  timer_.start(kCheckIntervalMs);
+}
+
+bool SuspensionPolicy::BubbleExempt(qlonglong bubble_id) {
+  return Ids("suspension/exemptBubbleIds").contains(bubble_id);
+}
+
+void SuspensionPolicy::SetBubbleExempt(qlonglong bubble_id, bool exempt) {
+  SetIdIncluded("suspension/exemptBubbleIds", bubble_id, exempt);
+}
+
+bool SuspensionPolicy::WorkspaceExempt(qlonglong workspace_id) {
+  return Ids("suspension/exemptWorkspaceIds").contains(workspace_id);
+}
+
+void SuspensionPolicy::SetWorkspaceExempt(qlonglong workspace_id,
+                                          bool exempt) {
+  SetIdIncluded("suspension/exemptWorkspaceIds", workspace_id, exempt);
+}
+
+void SuspensionPolicy::MarkActive(PageTreeItem* item) {
+  if (item) last_active_[item] = QDateTime::currentMSecsSinceEpoch();
+}
+
+void SuspensionPolicy::Check() {
+  // The current page is always in use
+  MarkActive(tree_->CurrentItem());
+  auto candidates = Candidates();
+  if (candidates.isEmpty()) return;
+
+  auto memory_reason = MemoryReason();
+  if (!memory_reason.isNull()) {
+    for (int i = 0; i < candidates.size() && i < kMaxSuspendedPerCheck; i++) {
+      Suspend(candidates[i], memory_reason);
+    }
+    candidates = candidates.mid(kMaxSuspendedPerCheck);
+  }
+
+  auto idle_mins = QSettings().value("suspension/idleMinutes", 0).toInt();
+  if (idle_mins <= 0) return;
+  auto idle_before =
+      QDateTime::currentMSecsSinceEpoch() - idle_mins * 60000ll;
+  for (auto item : candidates) {
+    // Oldest first, so the rest are newer
+    if (last_active_.value(item, started_) >= idle_before) break;
+    Suspend(item, QString("Inactive for over %1 minutes").arg(idle_mins));
+  }
+}
+
+QSet<qlonglong> SuspensionPolicy::Ids(const QString& key) {
+  QSet<qlonglong> ret;
+  for (const auto& id : QSettings().value(key).toList()) {
+    ret.insert(id.toLongLong());
+  }
+  return ret;
+}
+
+void SuspensionPolicy::SetIdIncluded(const QString& key,
+                                     qlonglong id,
+                                     bool include) {
+  auto ids = Ids(key);
+  if (include) {
+    ids.insert(id);
+  } else {
+    ids.remove(id);
+  }
+  QVariantList list;
+  for (auto id : ids) list.append(id);
+  QSettings().setValue(key, list);
+}
+
+QString SuspensionPolicy::MemoryReason() const {
+  QSettings settings;
+  auto min_percent =
+      settings.value("suspension/minAvailablePercent", 10).toDouble();
+  qlonglong total, available;
+  if (min_percent > 0 && Util::SystemMemory(&total, &available) &&
+      total > 0) {
+    auto percent = 100.0 * available / total;
+    if (percent < min_percent) {
+      return QString("Available memory at %1% (%2 of %3)").
+          arg(percent, 0, 'f', 1).
+          arg(Util::FriendlyByteSize(available)).
+          arg(Util::FriendlyByteSize(total));
+    }
+  }
+  auto max_pressure = settings.value("suspension/maxPressure", 20).toDouble();
+  if (max_pressure > 0) {
+    auto pressure = Util::MemoryPressure();
+    if (pressure > max_pressure) {
+      return QString("Memory pressure at %1").arg(pressure, 0, 'f', 1);
+    }
+  }
+  return QString();
+}
+
+QList<PageTreeItem*> SuspensionPolicy::Candidates() const {
+  auto exempt_bubbles = Ids("suspension/exemptBubbleIds");
+  auto exempt_workspaces = Ids("suspension/exemptWorkspaceIds");
+  QList<PageTreeItem*> ret;
+  auto current = tree_->CurrentItem();
+  QTreeWidgetItemIterator it(tree_);
+  while (*it) {
+    if ((*it)->type() == PageTree::kPageItemType) {
+      auto item = static_cast<PageTreeItem*>(*it);
+      if (item != current && !item->Placeholder() && !item->Suspended() &&
+          !exempt_bubbles.contains(item->CurrentBubble().Id()) &&
+          !exempt_workspaces.contains(item->CurrentWorkspace().Id())) {
+        ret.append(item);
+      }
+    }
+    it++;
+  }
+  std::stable_sort(ret.begin(), ret.end(),
+                   [=](PageTreeItem* a, PageTreeItem* b) {
+    return last_active_.value(a, started_) < last_active_.value(b, started_);
+  });
+  return ret;
+}
+
+void SuspensionPolicy::Suspend(PageTreeItem* item, const QString& reason) {
+  // Shows up in the logs dock
+  qInfo() << "Auto-suspending" << item->CurrentUrl() << "-" << reason;
+  tree_->SuspendItem(item);
+  static auto suspended = MetricsRegistry::GetCounter("pageTree.autoSuspended");
+  suspended->Increment();
+}
+
+}  // namespace doogie
@@ -0,0 +1,59 @@
+#ifndef DOOGIE_SUSPENSION_POLICY_H_
+#define DOOGIE_SUSPENSION_POLICY_H_
+
+#include <QtWidgets>
+
+namespace doogie {
+
+class PageTree;
+class PageTreeItem;
+
+// Suspends pages on its own, least recently active first, when system
+// memory runs low or when they have been idle too long. Settings (all
+// under suspension/):
+//  idleMinutes - suspend after this long inactive, 0 to never (default 0).
+//    Off by default since it can't tell a page is playing audio or has a
+//    half-filled form, both of which are lost on suspend.
+//  minAvailablePercent - below this much available memory, suspend until
+//    it's back up, 0 to never (default 10)
+//  maxPressure - above this PSI "some avg10" memory pressure, suspend until
+//    it's back down, 0 to never (default 20, Linux only)
+//  exemptBubbleIds, exemptWorkspaceIds - lists of IDs never auto-suspended
+class SuspensionPolicy : public QObject {
+  Q_OBJECT
+
+ public:
+  static const int kCheckIntervalMs = 30000;
+  // At most this many are suspended per check for memory, so we can see
+  //  what it did before doing more
+  static const int kMaxSuspendedPerCheck = 3;
+
+  explicit SuspensionPolicy(PageTree* tree);
+
+  static bool BubbleExempt(qlonglong bubble_id);
+  static void SetBubbleExempt(qlonglong bubble_id, bool exempt);
+  static bool WorkspaceExempt(qlonglong workspace_id);
+  static void SetWorkspaceExempt(qlonglong workspace_id, bool exempt);
+
+  void MarkActive(PageTreeItem* item);
+
+ private:
+  static QSet<qlonglong> Ids(const QString& key);
+  static void SetIdIncluded(const QString& key, qlonglong id, bool include);
+
+  void Check();
+  // Null reason if there is no memory problem
+  QString MemoryReason() const;
+  QList<PageTreeItem*> Candidates() const;
+  void Suspend(PageTreeItem* item, const QString& reason);
+
+  PageTree* tree_;
+  QTimer timer_;
+  QHash<PageTreeItem*, qint64> last_active_;
+  // Never-active pages count as active since we started
+  qint64 started_ = 0;
+};
+
+}  // namespace doogie
+
+#endif  // DOOGIE_SUSPENSION_POLICY_H_
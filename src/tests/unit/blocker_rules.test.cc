@@ -2,6 +2,7 @@
 #include <QtWidgets>
 
 #include "blocker_rules.h"
+#include "tests/unit/tests.h"
 
 namespace doogie {
 
@@ -86,7 +87,11 @@ class BlockerRulesTest : public QObject {
   }
 };
 
+int RunBlockerRulesTest(int argc, char* argv[]) {
+  BlockerRulesTest test;
+  return QTest::qExec(&test, argc, argv);
+}
+
 }  // namespace doogie
 
-QTEST_MAIN(doogie::BlockerRulesTest)
 #include "blocker_rules.test.moc"
@@ -0,0 +1,134 @@
+#include <QtTest>
+#include <QtWidgets>
+
+#include "download_sink.h"
+#include "tests/unit/tests.h"
+
+namespace doogie {
+
+class DownloadSinkTest : public QObject {
+  Q_OBJECT
+
+ private:
+  // Chunk boundaries are where the bugs are, so every byte is its own
+  bool WriteEachByte(DownloadSink* sink, const QByteArray& data) {
+    for (int i = 0; i < data.size(); i++) {
+      if (!sink->Write(data.constData() + i, 1)) return false;
+    }
+    return true;
+  }
+
+  // Raw deflate, from between qCompress's length prefix + zlib header and
+  // its adler32 trailer
+  QByteArray Deflate(const QByteArray& data) {
+    auto compressed = qCompress(data);
+    return compressed.mid(6, compressed.size() - 10);
+  }
+
+  QByteArray ZipEntry(const QString& name,
+                      const QByteArray& data,
+                      bool deflate) {
+    auto stored = deflate ? Deflate(data) : data;
+    auto name_bytes = name.toUtf8();
+    QByteArray ret;
+    QDataStream stream(&ret, QIODevice::WriteOnly);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    // Signature, version, flags, method, time, date and crc (not checked)
+    stream << quint32(0x04034b50) << quint16(20) << quint16(0) <<
+              quint16(deflate ? 8 : 0) << quint16(0) << quint16(0) <<
+              quint32(0);
+    stream << quint32(stored.size()) << quint32(data.size()) <<
+              quint16(name_bytes.size()) << quint16(0);
+    ret.append(name_bytes);
+    ret.append(stored);
+    return ret;
+  }
+
+  // Just enough to look like the start of a central directory
+  QByteArray ZipEnd() {
+    QByteArray ret;
+    QDataStream stream(&ret, QIODevice::WriteOnly);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream << quint32(0x02014b50);
+    return ret + QByteArray(26, '\0');
+  }
+
+  QByteArray Crx3Header() {
+    QByteArray header(100, 'x');
+    QByteArray ret("Cr24");
+    QDataStream stream(&ret, QIODevice::WriteOnly | QIODevice::Append);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream << quint32(3) << quint32(header.size());
+    return ret + header;
+  }
+
+ private slots:  // NOLINT(whitespace/indent)
+  void testZipStoredEntry() {
+    auto buffer = new BufferDownloadSink(1024);
+    ZipEntryDownloadSink sink("b.txt", buffer);
+    auto zip = ZipEntry("a.txt", "skipped", false) +
+        ZipEntry("b.txt", "wanted contents", false) + ZipEnd();
+    QVERIFY(WriteEachByte(&sink, zip));
+    QVERIFY(sink.Finish());
+    QCOMPARE(buffer->Data(), QByteArray("wanted contents"));
+  }
+
+  void testZipDeflatedEntryAfterCrx3Header() {
+    auto buffer = new BufferDownloadSink(1024 * 1024);
+    ZipEntryDownloadSink sink("data/b.txt", buffer);
+    QByteArray contents;
+    for (int i = 0; i < 1000; i++) contents += "line " + QByteArray::number(i);
+    auto zip = Crx3Header() + ZipEntry("a.txt", "skipped", true) +
+        ZipEntry("data/b.txt", contents, true) + ZipEnd();
+    QVERIFY(WriteEachByte(&sink, zip));
+    QVERIFY(sink.Finish());
+    QCOMPARE(buffer->Data(), contents);
+  }
+
+  void testZipEntryNotFound() {
+    ZipEntryDownloadSink sink("missing.txt", new BufferDownloadSink(1024));
+    auto zip = ZipEntry("a.txt", "foo", false) + ZipEnd();
+    QVERIFY(WriteEachByte(&sink, zip));
+    QVERIFY(!sink.Finish());
+    QVERIFY(sink.ErrorString().contains("missing.txt"));
+  }
+
+  void testInflateZlib() {
+    auto buffer = new BufferDownloadSink(1024);
+    InflateDownloadSink sink(InflateDownloadSink::GzipOrZlib, buffer);
+    // Without the length prefix it's plain zlib
+    QVERIFY(WriteEachByte(&sink, qCompress("some text").mid(4)));
+    QVERIFY(sink.Finish());
+    QCOMPARE(buffer->Data(), QByteArray("some text"));
+  }
+
+  void testInflateTruncated() {
+    InflateDownloadSink sink(InflateDownloadSink::GzipOrZlib,
+                             new BufferDownloadSink(1024));
+    auto compressed = qCompress("some text").mid(4);
+    QVERIFY(WriteEachByte(&sink, compressed.left(compressed.size() / 2)));
+    QVERIFY(!sink.Finish());
+  }
+
+  void testLineSplitAcrossWrites() {
+    QStringList lines;
+    LineDownloadSink sink([&](const QString& line) {
+      lines << line;
+      return true;
+    });
+    QVERIFY(WriteEachByte(&sink, "one\r\ntwo\n\nthree"));
+    // The last line only comes once we know it's done
+    QCOMPARE(lines, QStringList({ "one", "two", "" }));
+    QVERIFY(sink.Finish());
+    QCOMPARE(lines, QStringList({ "one", "two", "", "three" }));
+  }
+};
+
+int RunDownloadSinkTest(int argc, char* argv[]) {
+  DownloadSinkTest test;
+  return QTest::qExec(&test, argc, argv);
+}
+
+}  // namespace doogie
+
+#include "download_sink.test.moc"
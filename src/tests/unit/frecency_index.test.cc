@@ -0,0 +1,126 @@
+#include <QtTest>
+#include <QtWidgets>
+
+#include "frecency_index.h"
+#include "tests/unit/tests.h"
+
+namespace doogie {
+
+class FrecencyIndexTest : public QObject {
+  Q_OBJECT
+
+ private:
+  FrecencyIndex::Entry Page(qlonglong id,
+                            const QString& url,
+                            const QString& title,
+                            double frecency) {
+    FrecencyIndex::Entry entry;
+    entry.id = id;
+    entry.url = url;
+    entry.title = title;
+    entry.frecency = frecency;
+    entry.last_visited = id;
+    return entry;
+  }
+
+  QList<qlonglong> FoundIds(const FrecencyIndex& index,
+                            const QString& text,
+                            int count = 10) {
+    QList<FrecencyIndex::Entry> results;
+    if (!index.Find(text, count, &results)) return { -1 };
+    QList<qlonglong> ret;
+    for (const auto& entry : results) ret << entry.id;
+    return ret;
+  }
+
+ private slots:  // NOLINT(whitespace/indent)
+  void testMultiTokenPrefix() {
+    FrecencyIndex index(10);
+    index.SetComplete(true);
+    index.Upsert(Page(1, "https://example.com/foo", "Foo Bar", 1));
+    index.Upsert(Page(2, "https://example.org/", "Baz", 3));
+    index.Upsert(Page(3, "https://other.com/", "Example Stuff", 2));
+    // Both tokens have to prefix one of the page's, most frecent first
+    QCOMPARE(FoundIds(index, "exa ba"), QList<qlonglong>({ 2, 1 }));
+    QCOMPARE(FoundIds(index, "EXAMPLE"), QList<qlonglong>({ 2, 3, 1 }));
+    QCOMPARE(FoundIds(index, "example", 2), QList<qlonglong>({ 2, 3 }));
+    // The scheme isn't a token
+    QCOMPARE(FoundIds(index, "https"), QList<qlonglong>());
+    QCOMPARE(FoundIds(index, "exa nope"), QList<qlonglong>());
+  }
+
+  void testUpsertAtCapacity() {
+    FrecencyIndex index(2);
+    index.SetComplete(true);
+    index.Upsert(Page(1, "https://one.com/", "One", 1));
+    index.Upsert(Page(2, "https://two.com/", "Two", 2));
+    QVERIFY(index.Complete());
+    QCOMPARE(FoundIds(index, "one"), QList<qlonglong>({ 1 }));
+
+    // Evicts the least frecent, so it's no longer a full answer
+    index.Upsert(Page(3, "https://three.com/", "Three", 3));
+    QCOMPARE(index.Size(), 2);
+    QVERIFY(!index.Complete());
+    QCOMPARE(FoundIds(index, "one"), QList<qlonglong>({ -1 }));
+    QCOMPARE(FoundIds(index, "three", 1), QList<qlonglong>({ 3 }));
+    // Not enough matches for the count, the DB could have more
+    QCOMPARE(FoundIds(index, "three", 2), QList<qlonglong>({ -1 }));
+
+    // Less frecent than everything in it, so not added
+    index.Upsert(Page(4, "https://four.com/", "Four", 0.5));
+    QCOMPARE(index.Size(), 2);
+    QCOMPARE(FoundIds(index, "two", 1), QList<qlonglong>({ 2 }));
+    QCOMPARE(FoundIds(index, "four", 1), QList<qlonglong>({ -1 }));
+
+    // Replacing one by ID doesn't evict
+    index.Upsert(Page(2, "https://two.com/", "Two", 5));
+    QCOMPARE(index.Size(), 2);
+    QCOMPARE(FoundIds(index, "three", 1), QList<qlonglong>({ 3 }));
+  }
+
+  void testUpdateTitle() {
+    FrecencyIndex index(10);
+    index.SetComplete(true);
+    index.Upsert(Page(1, "https://example.com/", "Old Title", 1));
+    index.UpdateTitle("https://example.com/", "New Name");
+    QCOMPARE(FoundIds(index, "old"), QList<qlonglong>());
+    QCOMPARE(FoundIds(index, "new na"), QList<qlonglong>({ 1 }));
+    QCOMPARE(FoundIds(index, "example"), QList<qlonglong>({ 1 }));
+    // Unknown URLs are ignored
+    index.UpdateTitle("https://other.com/", "Old");
+    QCOMPARE(FoundIds(index, "old"), QList<qlonglong>());
+    QCOMPARE(index.Size(), 1);
+  }
+
+  void testRemoveAndCompact() {
+    FrecencyIndex index(1000);
+    index.SetComplete(true);
+    // Long distinct tokens so the trie is big enough to compact
+    for (int i = 0; i < 300; i++) {
+      index.Upsert(Page(i, QString("https://site%1.com/").arg(i),
+                        QString("token%1abcdefgh").arg(i), i));
+    }
+    for (int i = 0; i < 295; i++) index.Remove(i);
+    QCOMPARE(index.Size(), 5);
+    QCOMPARE(FoundIds(index, "token1abc"), QList<qlonglong>());
+    QCOMPARE(FoundIds(index, "token297"), QList<qlonglong>({ 297 }));
+    QCOMPARE(FoundIds(index, "token"),
+             QList<qlonglong>({ 299, 298, 297, 296, 295 }));
+    QCOMPARE(FoundIds(index, "site29"),
+             QList<qlonglong>({ 299, 298, 297, 296, 295 }));
+    // Still works after the rebuild
+    index.Upsert(Page(1000, "https://new.com/", "Token Fresh", 1000));
+    QCOMPARE(FoundIds(index, "token fr"), QList<qlonglong>({ 1000 }));
+    index.RemoveVisitedBefore(298);
+    QCOMPARE(FoundIds(index, "token"), QList<qlonglong>({ 1000, 299, 298 }));
+  }
+};
+
+int RunFrecencyIndexTest(int argc, char* argv[]) {
+  FrecencyIndexTest test;
+  return QTest::qExec(&test, argc, argv);
+}
+
+}  // namespace doogie
+
+#include "frecency_index.test.moc"
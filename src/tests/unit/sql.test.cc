@@ -0,0 +1,92 @@
+#include <QtSql>
+#include <QtTest>
+#include <QtWidgets>
+
+#include <cmath>
+
+#include "page_index.h"
+#include "sql.h"
+#include "tests/unit/tests.h"
+
+namespace doogie {
+
+class SqlTest : public QObject {
+  Q_OBJECT
+
+ private:
+  // Same as Sql::ExecScript, so we can stop at an older version
+  void ApplyScript(const QString& res_name) {
+    QFile file(res_name);
+    QVERIFY(file.open(QIODevice::ReadOnly | QIODevice::Text));
+    QSqlQuery query;
+    for (auto stmt : QString::fromUtf8(file.readAll()).split("\n\n")) {
+      auto has_stmt = false;
+      for (const auto& line : stmt.split('\n')) {
+        auto trimmed = line.trimmed();
+        if (!trimmed.isEmpty() && !trimmed.startsWith("--")) has_stmt = true;
+      }
+      if (has_stmt) QVERIFY2(query.exec(stmt), qPrintable(stmt));
+    }
+  }
+
+  int UserVersion() {
+    QSqlQuery query;
+    if (!query.exec("PRAGMA user_version") || !query.next()) return -1;
+    return query.value(0).toInt();
+  }
+
+ private slots:  // NOLINT(whitespace/indent)
+  void init() {
+    auto db = QSqlDatabase::addDatabase("QSQLITE");
+    db.setDatabaseName(":memory:");
+    QVERIFY(db.open());
+  }
+
+  void cleanup() {
+    QSqlDatabase::database().close();
+    QSqlDatabase::removeDatabase(QSqlDatabase::defaultConnection);
+  }
+
+  void testNewDatabase() {
+    QVERIFY(Sql::EnsureDatabaseSchema());
+    QCOMPARE(UserVersion(), Sql::kSchemaVersion);
+  }
+
+  void testMigrateFromVersion3() {
+    ApplyScript(":/res/schema.sql");
+    ApplyScript(":/res/migrations/2.sql");
+    ApplyScript(":/res/migrations/3.sql");
+    QSqlQuery query;
+    QVERIFY(query.exec("PRAGMA user_version = 3"));
+    // Two and a half half-lives past the epoch, which the old seed
+    // rounded down
+    auto last_visited = PageIndex::kFrecencyEpochSeconds +
+        PageIndex::kFrecencyHalfLifeSeconds * 5 / 2;
+    QVERIFY(query.prepare(
+        "INSERT INTO autocomplete_page (url, url_hash, schemeless_url, "
+        "  title, last_visited, visit_count, frecency) "
+        "VALUES ('http://example.com/', 0, 'example.com/', 'Example', "
+        "  ?, 2, 0)"));
+    query.addBindValue(last_visited);
+    QVERIFY(query.exec());
+
+    QVERIFY(Sql::EnsureDatabaseSchema({ { 4, &PageIndex::SeedFrecency } }));
+    QCOMPARE(UserVersion(), Sql::kSchemaVersion);
+    QVERIFY(query.exec("SELECT frecency FROM autocomplete_page"));
+    QVERIFY(query.next());
+    QVERIFY(qFuzzyCompare(query.value(0).toDouble(),
+                          2 * std::pow(2.0, 2.5)));
+    // The recreated FTS table has the existing page
+    QVERIFY(query.exec("SELECT rowid FROM autocomplete_page_fts('\"exa\"*')"));
+    QVERIFY(query.next());
+  }
+};
+
+int RunSqlTest(int argc, char* argv[]) {
+  SqlTest test;
+  return QTest::qExec(&test, argc, argv);
+}
+
+}  // namespace doogie
+
+#include "sql.test.moc"
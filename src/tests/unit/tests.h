@@ -0,0 +1,15 @@
+#ifndef DOOGIE_TESTS_UNIT_TESTS_H_
+#define DOOGIE_TESTS_UNIT_TESTS_H_
+
+namespace doogie {
+
+// Each test file has one of these, all run by tests.test.cc. They give
+// the QTest::qExec result.
+int RunBlockerRulesTest(int argc, char* argv[]);
+int RunDownloadSinkTest(int argc, char* argv[]);
+int RunFrecencyIndexTest(int argc, char* argv[]);
+int RunSqlTest(int argc, char* argv[]);
+
+}  // namespace doogie
+
+#endif  // DOOGIE_TESTS_UNIT_TESTS_H_
@@ -4,7 +4,13 @@ test {
     # Have to remove main
     SOURCES -= main.cc
     SOURCES += \
-        tests/unit/blocker_rules.test.cc
+        tests/unit/blocker_rules.test.cc \
+        tests/unit/download_sink.test.cc \
+        tests/unit/frecency_index.test.cc \
+        tests/unit/sql.test.cc \
+        tests/unit/tests.test.cc
+    HEADERS += \
+        tests/unit/tests.h
     TARGET = doogie-test
 }
 
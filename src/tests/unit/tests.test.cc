@@ -0,0 +1,15 @@
+#include <QtTest>
+#include <QtWidgets>
+
+#include "tests/unit/tests.h"
+
+// QTEST_MAIN only handles one test class per binary
+int main(int argc, char* argv[]) {
+  QApplication app(argc, argv);
+  auto failed = 0;
+  failed += doogie::RunBlockerRulesTest(argc, argv);
+  failed += doogie::RunDownloadSinkTest(argc, argv);
+  failed += doogie::RunFrecencyIndexTest(argc, argv);
+  failed += doogie::RunSqlTest(argc, argv);
+  return failed;
+}
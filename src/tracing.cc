@@ -0,0 +1,216 @@
+#include "tracing.h"
+
+#include "cef/cef_base.h"
+#include "util.h"
+
+namespace doogie {
+
+std::atomic<bool> Tracing::recording_ { false };
+bool Tracing::include_chromium_ = false;
+QMutex Tracing::events_mutex_;
+QVector<Tracing::Event> Tracing::events_;
+int Tracing::dropped_events_ = 0;
+
+class Tracing::EndCallback : public CefEndTracingCallback {
+ public:
+  explicit EndCallback(std::function<void(const QString&)> callback)
+    : callback_(callback) {}
+  void OnEndTracingComplete(const CefString& tracing_file) override {
+    callback_(QString::fromStdString(tracing_file.ToString()));
+  }
+
+ private:
+  std::function<void(const QString&)> callback_;
+  IMPLEMENT_REFCOUNTING(EndCallback);
+  DISALLOW_COPY_AND_ASSIGN(EndCallback);
+};
+
+Tracing::Span::Span(const char* category,
+                    const char* name,
+                    const QString& detail)
+    : category_(category), name_(name) {
+  if (!Recording()) return;
+  detail_ = detail;
+  start_us_ = NowUs();
+}
+
+Tracing::Span::~Span() {
+  // Spans that straddle a stop are just lost
+  if (start_us_ < 0 || !Recording()) return;
+  Add({ category_, name_, detail_, start_us_, NowUs() - start_us_,
+        Util::CurrentThreadId() });
+}
+
+bool Tracing::Start(bool include_chromium) {
+  if (Recording()) return false;
+  if (include_chromium && !CefBeginTracing(CefString(), nullptr)) {
+    qWarning() << "Unable to start Chromium tracing";
+    return false;
+  }
+  include_chromium_ = include_chromium;
+  {
+    QMutexLocker locker(&events_mutex_);
+    events_.clear();
+    dropped_events_ = 0;
+  }
+  recording_ = true;
+  qInfo() << "Tracing started";
+  return true;
+}
+
+void Tracing::Stop(const QString& path, std::function<void(bool)> callback) {
+  if (!Recording()) {
+    callback(false);
+    return;
+  }
+  recording_ = false;
+  auto events = TakeEvents();
+  if (!include_chromium_) {
+    callback(Write(path, events, QString()));
+    return;
+  }
+  // Chromium writes its part to a file of its own first
+  auto chromium_path = QDir::temp().filePath(
+        QString("doogie-chromium-trace-%1.json").
+        arg(QCoreApplication::applicationPid()));
+  auto ended = CefEndTracing(
+        CefString(chromium_path.toStdString()),
+        new EndCallback([=](const QString& file) {
+    callback(Write(path, events, file));
+  }));
+  if (!ended) {
+    qWarning() << "Unable to stop Chromium tracing";
+    callback(Write(path, events, QString()));
+  }
+}
+
+qint64 Tracing::NowUs() {
+  // Same clock Chromium stamps its events w/
+  return CefNowFromSystemTraceTime();
+}
+
+void Tracing::Add(const Event& event) {
+  QMutexLocker locker(&events_mutex_);
+  if (events_.size() >= kMaxEvents) {
+    dropped_events_++;
+    return;
+  }
+  events_.append(event);
+}
+
+QVector<Tracing::Event> Tracing::TakeEvents() {
+  QMutexLocker locker(&events_mutex_);
+  if (dropped_events_ > 0) {
+    qWarning() << "Trace dropped" << dropped_events_ << "events over the" <<
+                  kMaxEvents << "limit";
+  }
+  QVector<Event> ret;
+  ret.swap(events_);
+  dropped_events_ = 0;
+  return ret;
+}
+
+bool Tracing::Write(const QString& path,
+                    const QVector<Event>& events,
+                    const QString& chromium_path) {
+  QSaveFile file(path);
+  if (!file.open(QIODevice::WriteOnly)) {
+    qWarning() << "Unable to open trace file" << path;
+    if (!chromium_path.isNull()) QFile::remove(chromium_path);
+    return false;
+  }
+  file.write("{\"traceEvents\":[\n");
+  auto chromium_events = 0;
+  if (!chromium_path.isNull()) {
+    QFile chromium_file(chromium_path);
+    if (chromium_file.open(QIODevice::ReadOnly)) {
+      chromium_events = CopyChromiumEvents(&chromium_file, &file);
+      chromium_file.close();
+      chromium_file.remove();
+    }
+    if (chromium_events == 0) {
+      qWarning() << "No Chromium trace events found in" << chromium_path;
+    } else if (chromium_events < 0) {
+      // A partial copy leaves the file broken
+      qWarning() << "Chromium trace in" << chromium_path << "ended early";
+      file.cancelWriting();
+      return false;
+    }
+  }
+  // Written one event at a time so we never build one giant document
+  auto first = chromium_events == 0;
+  auto write_event = [&](const QJsonObject& obj) {
+    if (!first) file.write(",\n");
+    first = false;
+    file.write(QJsonDocument(obj).toJson(QJsonDocument::Compact));
+  };
+  auto pid = QCoreApplication::applicationPid();
+  for (const auto& event : events) {
+    QJsonObject obj {
+      { "ph", "X" },
+      { "cat", QString::fromLatin1(event.category) },
+      { "name", QString::fromLatin1(event.name) },
+      { "pid", pid },
+      { "tid", event.tid },
+      { "ts", event.ts_us },
+      { "dur", event.dur_us }
+    };
+    if (!event.detail.isEmpty()) {
+      obj["args"] = QJsonObject { { "detail", event.detail } };
+    }
+    write_event(obj);
+  }
+  file.write("\n]}\n");
+  if (!file.commit()) {
+    qWarning() << "Unable to write trace file" << path;
+    return false;
+  }
+  qInfo() << "Trace with" << events.size() << "events (plus" <<
+             chromium_events << "from Chromium) written to" << path;
+  return true;
+}
+
+int Tracing::CopyChromiumEvents(QIODevice* from, QIODevice* to) {
+  // It's either the bare array or an object w/ traceEvents, which
+  // Chromium writes first, so the start is always near the top
+  auto head = from->peek(4096);
+  auto start = head.indexOf("\"traceEvents\"");
+  start = head.indexOf('[', qMax(start, 0));
+  if (start < 0) return 0;
+  from->read(start + 1);
+  // Only the brackets and braces outside of strings count
+  auto depth = 1;
+  auto events = 0;
+  auto in_string = false;
+  auto escaped = false;
+  while (depth > 0 && !from->atEnd()) {
+    auto chunk = from->read(kCopyChunkSize);
+    auto end = chunk.size();
+    for (int i = 0; i < chunk.size(); i++) {
+      auto c = chunk.at(i);
+      if (in_string) {
+        if (escaped) {
+          escaped = false;
+        } else if (c == '\\') {
+          escaped = true;
+        } else if (c == '"') {
+          in_string = false;
+        }
+      } else if (c == '"') {
+        in_string = true;
+      } else if (c == '[' || c == '{') {
+        if (depth == 1 && c == '{') events++;
+        depth++;
+      } else if ((c == ']' || c == '}') && --depth == 0) {
+        end = i;
+        break;
+      }
+    }
+    to->write(chunk.constData(), end);
+  }
+  return depth == 0 ? events : -1;
+}
+
+Tracing::Tracing() { }
+
+}  // namespace doogie
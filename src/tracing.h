@@ -0,0 +1,91 @@
+#ifndef DOOGIE_TRACING_H_
+#define DOOGIE_TRACING_H_
+
+#include <QtWidgets>
+
+#include <atomic>
+#include <functional>
+
+namespace doogie {
+
+// Records spans of our own work in the Chrome trace event format (for
+// chrome://tracing or Perfetto) while turned on. When off, a span costs
+// a single atomic load. Chromium's own trace can be recorded at the same
+// time, in which case it is merged in when saved so both show on one
+// timeline: the timestamps and thread IDs are the ones Chromium uses.
+class Tracing {
+ public:
+  // Past this, spans are dropped until saved
+  static const int kMaxEvents = 1000000;
+  // Chromium's trace is copied over this many bytes at a time
+  static const int kCopyChunkSize = 1024 * 1024;
+
+  // Records from construction to destruction, on whatever thread. The
+  // category and name must be literals, the detail is only kept when
+  // recording.
+  class Span {
+   public:
+    Span(const char* category,
+         const char* name,
+         const QString& detail = QString());
+    ~Span();
+
+   private:
+    const char* category_;
+    const char* name_;
+    QString detail_;
+    // Negative if not recording when started
+    qint64 start_us_ = -1;
+    Q_DISABLE_COPY(Span)
+  };
+
+  static bool Recording() {
+    return recording_.load(std::memory_order_relaxed);
+  }
+
+  // Must be called on the GUI thread after CEF is initialized. False if
+  //  already recording or Chromium tracing couldn't be started.
+  static bool Start(bool include_chromium);
+  // Must be called on the GUI thread. The callback is called on the GUI
+  //  thread w/ whether it was saved, possibly after this returns when
+  //  waiting on Chromium.
+  static void Stop(const QString& path, std::function<void(bool)> callback);
+
+ private:
+  // Hands Chromium's trace file back, defined w/ the CEF bits
+  class EndCallback;
+
+  struct Event {
+    const char* category;
+    const char* name;
+    QString detail;
+    qint64 ts_us;
+    qint64 dur_us;
+    qint64 tid;
+  };
+
+  static qint64 NowUs();
+  static void Add(const Event& event);
+  static QVector<Event> TakeEvents();
+  // Chromium's events are written first, ours after. The Chromium file is
+  //  removed after, null if there isn't one.
+  static bool Write(const QString& path,
+                    const QVector<Event>& events,
+                    const QString& chromium_path);
+  // Copies what's inside Chromium's traceEvents array as is, w/out parsing
+  //  it since it can be bigger than QJsonDocument allows. Gives how many
+  //  events were copied, 0 if there's no array, or -1 if it didn't end.
+  static int CopyChromiumEvents(QIODevice* from, QIODevice* to);
+
+  static std::atomic<bool> recording_;
+  static bool include_chromium_;
+  static QMutex events_mutex_;
+  static QVector<Event> events_;
+  static int dropped_events_;
+
+  Tracing();
+};
+
+}  // namespace doogie
+
+#endif  // DOOGIE_TRACING_H_
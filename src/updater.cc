@@ -39,28 +39,23 @@ QString Updater::CrlFilePath() const {
 void Updater::CheckCrlUpdates() const {
   // First have to fetch the URL. Yes we ignore version and only use
   // file timestamp because it's easier to not store version state.
-  auto buf = new QBuffer;
-  buf->open(QIODevice::ReadWrite);
-  cef_.Download(kCrlCheckUrl, buf,
-                [=](CefRefPtr<CefURLRequest> req, QIODevice* device) {
+  auto sink = new BufferDownloadSink(kMaxCrlCheckSize);
+  cef_.Download(kCrlCheckUrl, sink,
+                [=](CefRefPtr<CefURLRequest>, const QString& error) {
     auto failed_retry = [=](const QString& reason) {
       qWarning() << "Failed CRL update, reason:" << reason;
       QTimer::singleShot(kCrlUpdateFailRetrySeconds * 1000,
                          this, &Updater::CheckCrlUpdates);
     };
-    if (req->GetRequestStatus() != UR_SUCCESS) {
-      failed_retry("Download failure");
+    if (!error.isEmpty()) {
+      failed_retry(error);
       return;
     }
 
-    // We'd do a lot better streaming this, but meh, it's not a big deal
-    auto buf = qobject_cast<QBuffer*>(device);
-    buf->seek(0);
-    // It's mine to delete
-    buf->deleteLater();
-    auto data = reinterpret_cast<void*>(
-          const_cast<char*>(buf->data().constData()));
-    auto stream = CefStreamReader::CreateForData(data, buf->data().size());
+    // The sink lives until we return, so we can read right out of it
+    const auto& data = sink->Data();
+    auto stream = CefStreamReader::CreateForData(
+          const_cast<char*>(data.constData()), data.size());
     if (!stream) {
       failed_retry("Bad XML data");
       return;
@@ -93,50 +88,17 @@ void Updater::CheckCrlUpdates() const {
 void Updater::UpdateCrl(const QString& crx_url) const {
   qDebug() << "Updating CRLs from" << crx_url;
 
-  // Get the CRX file in mem, load as ZIP, extract crl-set out of it and
-  //  save it
-  auto buf = new QBuffer;
-  buf->open(QIODevice::ReadWrite);
-  cef_.Download(crx_url, buf,
-                [=](CefRefPtr<CefURLRequest> /*req*/, QIODevice* device) {
-    auto failed_retry = [=](const QString& reason) {
-      qWarning() << "Failed CRL update, reason:" << reason;
+  // Stream the crl-set entry of the CRX straight to the local file
+  auto sink = new ZipEntryDownloadSink("crl-set",
+                                       new FileDownloadSink(CrlFilePath()));
+  cef_.Download(crx_url, sink,
+                [=](CefRefPtr<CefURLRequest>, const QString& error) {
+    if (!error.isEmpty()) {
+      qWarning() << "Failed CRL update, reason:" << error;
       QTimer::singleShot(kCrlUpdateFailRetrySeconds * 1000,
                          this, &Updater::CheckCrlUpdates);
-    };
-    // We'd do a lot better streaming this, but meh, it's not a big deal
-    auto buf = qobject_cast<QBuffer*>(device);
-    buf->seek(0);
-    // It's mine to delete
-    buf->deleteLater();
-    auto data = reinterpret_cast<void*>(
-          const_cast<char*>(buf->data().constData()));
-    auto stream = CefStreamReader::CreateForData(data, buf->data().size());
-    if (!stream) {
-      failed_retry("Bad CRX data");
-      return;
-    }
-    // Load the zip
-    CefRefPtr<CefZipArchive> archive = new CefZipArchive();
-    if (!archive ||
-        archive->Load(stream, CefString(), false) <= 0 ||
-        !archive->HasFile("crl-set")) {
-      failed_retry("Bad CRX zip");
-      return;
-    }
-    // Write crl-set to local file
-    auto file = archive->GetFile("crl-set");
-    QFile local_file(CrlFilePath());
-    if (!local_file.open(QFile::WriteOnly)) {
-      failed_retry("Failed local file open");
-      return;
-    }
-    if (local_file.write(reinterpret_cast<const char*>(file->GetData()),
-                         file->GetDataSize()) < 0) {
-      failed_retry("Failed local file write");
       return;
     }
-    local_file.close();
     // Apply back on main thread
     Util::RunOnMainThread([=]() { ApplyCrlFromFileAndScheduleUpdate(); });
   });
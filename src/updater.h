@@ -17,6 +17,8 @@ class Updater : public QObject {
  private:
   static const int kCrlUpdateFailRetrySeconds = 300;
   static const int kCheckCrlUpdateFrequencySeconds = 5 * 3600;
+  // The update check is a tiny XML doc, anything past this is bogus
+  static const int kMaxCrlCheckSize = 1024 * 1024;
   static const QString kCrlCheckUrl;
 
   void ApplyCrlFromFileAndScheduleUpdate() const;
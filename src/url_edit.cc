@@ -1,7 +1,7 @@
 #include "url_edit.h"
 
 #include "cef/cef.h"
-#include "page_index.h"
+#include "favicon_store.h"
 
 namespace doogie {
 
@@ -39,6 +39,10 @@ UrlEdit::UrlEdit(const Cef& cef, QWidget* parent) :
   connect(this, &UrlEdit::textEdited, this, &UrlEdit::HandleTextEdit);
 }
 
+UrlEdit::~UrlEdit() {
+  if (cancel_suggest_) cancel_suggest_();
+}
+
 void UrlEdit::focusInEvent(QFocusEvent* event) {
   QLineEdit::focusInEvent(event);
 }
@@ -113,53 +117,37 @@ void UrlEdit::keyPressEvent(QKeyEvent* event) {
 }
 
 void UrlEdit::HandleTextEdit(const QString& text) {
+  // Whatever was in flight is no longer wanted
+  if (cancel_suggest_) {
+    cancel_suggest_();
+    cancel_suggest_ = nullptr;
+  }
   if (text.isEmpty()) {
     autocomplete_->hide();
     return;
   }
 
   autocomplete_->clear();
-  auto height = 20;
-  auto incr_height = [=, &height]() {
-    height += autocomplete_->sizeHintForRow(autocomplete_->count() - 1);
-  };
 
   auto looks_like_search = text.startsWith("!") || text.contains(" !");
   auto search_item = new QListWidgetItem("Search DuckDuckGo for: " + text);
   search_item->setData(kRoleAutocompleteUrl,
                        QString("https://duckduckgo.com/?q=") +
                          QUrl::toPercentEncoding(text));
-  if (looks_like_search) {
-    autocomplete_->addItem(search_item);
-    incr_height();
-  }
+  if (looks_like_search) autocomplete_->addItem(search_item);
 
   // If it's a valid UR (but doens't look like search), first result is "visit"
   auto looks_like_url = (text.contains(":/") || text.contains(".")) &&
       cef_.IsValidUrl(text);
   auto visit_item = new QListWidgetItem("Visit: " + text);
   visit_item->setData(kRoleAutocompleteUrl, text);
-  if (looks_like_url) {
-    autocomplete_->addItem(visit_item);
-    incr_height();
-  }
+  if (looks_like_url) autocomplete_->addItem(visit_item);
 
-  for (const auto& suggest : PageIndex::AutocompleteSuggest(text, 10)) {
-    auto item = new QListWidgetItem(
-          suggest.favicon, suggest.title + " - " + suggest.url);
-    item->setData(kRoleAutocompleteUrl, suggest.url);
-    autocomplete_->addItem(item);
-    incr_height();
-  }
+  // Suggestions are put here when they arrive
+  auto suggest_row = autocomplete_->count();
 
-  if (!looks_like_search) {
-    autocomplete_->addItem(search_item);
-    incr_height();
-  }
-  if (!looks_like_url) {
-    autocomplete_->addItem(visit_item);
-    incr_height();
-  }
+  if (!looks_like_search) autocomplete_->addItem(search_item);
+  if (!looks_like_url) autocomplete_->addItem(visit_item);
 
   // Set the first one as selected, but block signal so the URL edit
   //  doesn't change
@@ -169,8 +157,52 @@ void UrlEdit::HandleTextEdit(const QString& text) {
 
   autocomplete_->move(mapToGlobal(rect().bottomLeft()));
   autocomplete_->setFixedWidth(width());
-  autocomplete_->setFixedHeight(height);
+  ResizeAutocomplete();
   autocomplete_->show();
+
+  QPointer<UrlEdit> self(this);
+  cancel_suggest_ = PageIndex::AutocompleteSuggest(
+        text, 10, [=](QList<PageIndex::AutocompletePage> pages) {
+    if (self) self->InsertSuggestions(suggest_row, pages);
+  });
+}
+
+void UrlEdit::InsertSuggestions(
+    int row, const QList<PageIndex::AutocompletePage>& pages) {
+  if (pages.isEmpty() || !autocomplete_->isVisible()) return;
+  // Keep whatever was selected while we waited
+  auto current = autocomplete_->currentItem();
+  for (const auto& page : pages) {
+    auto item = new QListWidgetItem(page.title + " - " + page.url);
+    item->setData(kRoleAutocompleteUrl, page.url);
+    item->setData(kRoleAutocompleteFaviconId, page.favicon_id);
+    autocomplete_->insertItem(row++, item);
+  }
+  autocomplete_->blockSignals(true);
+  if (current) autocomplete_->setCurrentItem(current);
+  autocomplete_->blockSignals(false);
+  ResizeAutocomplete();
+  // Icons are loaded after the list is shown
+  QTimer::singleShot(0, this, &UrlEdit::LoadAutocompleteFavicons);
+}
+
+void UrlEdit::LoadAutocompleteFavicons() {
+  for (int i = 0; i < autocomplete_->count(); i++) {
+    auto item = autocomplete_->item(i);
+    auto favicon_id = item->data(kRoleAutocompleteFaviconId);
+    if (favicon_id.isNull()) continue;
+    item->setIcon(FaviconStore::Icon(favicon_id));
+    item->setData(kRoleAutocompleteFaviconId, QVariant());
+  }
+  ResizeAutocomplete();
+}
+
+void UrlEdit::ResizeAutocomplete() {
+  auto height = 20;
+  for (int i = 0; i < autocomplete_->count(); i++) {
+    height += autocomplete_->sizeHintForRow(i);
+  }
+  autocomplete_->setFixedHeight(height);
 }
 
 }  // namespace doogie
@@ -3,6 +3,7 @@
 
 #include <QtWidgets>
 #include "cef/cef.h"
+#include "page_index.h"
 
 namespace doogie {
 
@@ -11,6 +12,7 @@ class UrlEdit : public QLineEdit {
   Q_OBJECT
  public:
   explicit UrlEdit(const Cef& cef, QWidget* parent);
+  ~UrlEdit();
 
  signals:
   void UrlEntered();
@@ -22,12 +24,18 @@ class UrlEdit : public QLineEdit {
 
  private:
   static const int kRoleAutocompleteUrl = Qt::UserRole + 1;
+  static const int kRoleAutocompleteFaviconId = Qt::UserRole + 2;
 
   void HandleTextEdit(const QString& text);
+  void InsertSuggestions(int row,
+                         const QList<PageIndex::AutocompletePage>& pages);
+  void LoadAutocompleteFavicons();
+  void ResizeAutocomplete();
 
   const Cef& cef_;
   QListWidget* autocomplete_;
   QString typed_before_moved_;
+  std::function<void()> cancel_suggest_;
 };
 
 }  // namespace doogie
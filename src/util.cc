@@ -1,5 +1,7 @@
 #include "util.h"
 
+#include "main_thread_queue.h"
+
 namespace doogie {
 
 QPixmap* Util::CachedPixmap(const QString& res_name) {
@@ -125,11 +127,7 @@ QString Util::FriendlyTimeSpan(qint64 seconds) {
 }
 
 void Util::RunOnMainThread(std::function<void()> fn) {
-  // A bit ghetto to rely on the stack destruction but meh
-  // Ref: https://stackoverflow.com/questions/21646467/how-to-execute-a-functor-or-a-lambda-in-a-given-thread-in-qt-gcd-style
-  QObject obj;
-  QObject::connect(&obj, &QObject::destroyed, QApplication::instance(),
-                   fn, Qt::QueuedConnection);
+  MainThreadQueue::Post(fn);
 }
 
 }  // namespace doogie
@@ -33,6 +33,17 @@ class Util {
   // Unlike QCoreApplication::applicationFilePath, this does not require a Qt
   //  application instance to obtain the path. Null string on error.
   static QString ExePath();
+
+  // The OS's ID for the calling thread, same as Chromium uses in traces
+  static qint64 CurrentThreadId();
+
+  // Resident set size of this process, 0 if unknown
+  static qlonglong ResidentMemoryBytes();
+  // Whole system, false if unknown
+  static bool SystemMemory(qlonglong* total, qlonglong* available);
+  // Percent of time some tasks were stalled on memory over the last 10
+  //  seconds (Linux PSI), -1 if unknown
+  static double MemoryPressure();
 };
 
 }  // namespace doogie
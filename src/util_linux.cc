@@ -1,5 +1,6 @@
 #include "util.h"
 
+#include <sys/syscall.h>
 #include <unistd.h>
 
 namespace doogie {
@@ -10,10 +11,58 @@ bool Util::OpenContainingFolder(const QString& path) {
     QUrl::fromLocalFile(info.isDir() ? path : info.path()));
 }
 
+qint64 Util::CurrentThreadId() {
+  // Not the pthread ID Qt gives, and glibc only recently got gettid
+  static thread_local qint64 tid = syscall(SYS_gettid);
+  return tid;
+}
+
 QString Util::ExePath() {
   QFileInfo pfi(QString::fromLatin1("/proc/%1/exe").arg(::getpid()));
   if (!pfi.exists() || !pfi.isSymLink()) return QString();
   return pfi.canonicalFilePath();
 }
 
+qlonglong Util::ResidentMemoryBytes() {
+  // Second field is resident pages
+  QFile file("/proc/self/statm");
+  if (!file.open(QIODevice::ReadOnly)) return 0;
+  auto fields = file.readAll().split(' ');
+  if (fields.size() < 2) return 0;
+  return fields[1].toLongLong() * ::sysconf(_SC_PAGESIZE);
+}
+
+bool Util::SystemMemory(qlonglong* total, qlonglong* available) {
+  QFile file("/proc/meminfo");
+  if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) return false;
+  *total = -1;
+  *available = -1;
+  // Lines are like "MemTotal:       16316412 kB"
+  for (const auto& line : QString(file.readAll()).split('\n')) {
+    auto fields = line.simplified().split(' ');
+    if (fields.size() < 2) continue;
+    if (fields[0] == "MemTotal:") {
+      *total = fields[1].toLongLong() * 1024;
+    } else if (fields[0] == "MemAvailable:") {
+      *available = fields[1].toLongLong() * 1024;
+    }
+  }
+  return *total >= 0 && *available >= 0;
+}
+
+double Util::MemoryPressure() {
+  // Only there w/ newer kernels, first line is like
+  //  "some avg10=0.00 avg60=0.00 avg300=0.00 total=0"
+  QFile file("/proc/pressure/memory");
+  if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) return -1;
+  for (const auto& field : QString(file.readLine()).simplified().split(' ')) {
+    if (field.startsWith("avg10=")) {
+      auto ok = false;
+      auto ret = field.mid(6).toDouble(&ok);
+      return ok ? ret : -1;
+    }
+  }
+  return -1;
+}
+
 }  // namespace doogie
@@ -1,5 +1,8 @@
 #include "util.h"
 
+#include <windows.h>
+#include <psapi.h>
+
 namespace doogie {
 
 bool Util::OpenContainingFolder(const QString& path) {
@@ -10,6 +13,10 @@ bool Util::OpenContainingFolder(const QString& path) {
   return QProcess::startDetached(explorer + " " + param);
 }
 
+qint64 Util::CurrentThreadId() {
+  return GetCurrentThreadId();
+}
+
 QString Util::ExePath() {
   wchar_t buffer[MAX_PATH];
   auto ret = GetModuleFileName(nullptr, buffer, MAX_PATH);
@@ -17,4 +24,27 @@ QString Util::ExePath() {
   return QString::fromWCharArray(buffer, ret);
 }
 
+qlonglong Util::ResidentMemoryBytes() {
+  PROCESS_MEMORY_COUNTERS counters;
+  if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters,
+                            sizeof(counters))) {
+    return 0;
+  }
+  return counters.WorkingSetSize;
+}
+
+bool Util::SystemMemory(qlonglong* total, qlonglong* available) {
+  MEMORYSTATUSEX status;
+  status.dwLength = sizeof(status);
+  if (!GlobalMemoryStatusEx(&status)) return false;
+  *total = status.ullTotalPhys;
+  *available = status.ullAvailPhys;
+  return true;
+}
+
+double Util::MemoryPressure() {
+  // No PSI here
+  return -1;
+}
+
 }  // namespace doogie
@@ -1,10 +1,20 @@
 #include "workspace.h"
 
+#include "favicon_store.h"
+#include "screenshot_cache.h"
 #include "sql.h"
 
 namespace doogie {
 
+QHash<qlonglong, QVariantHash> Workspace::WorkspacePage::pending_updates_;
+QSet<qlonglong> Workspace::WorkspacePage::pending_deletes_;
+QSet<qlonglong> Workspace::WorkspacePage::keys_to_forget_;
+QTimer* Workspace::WorkspacePage::pending_updates_timer_ = nullptr;
+
 bool Workspace::WorkspacePage::BubbleInUse(qlonglong bubble_id) {
+  // Held updates and deletes have to land first
+  FlushPendingUpdates();
+  SqlExecutor::WaitFor("workspace_page");
   QSqlQuery query;
   QString sql = "SELECT EXISTS( "
                 " SELECT 1 FROM workspace_page WHERE bubble_id = ? LIMIT 1 "
@@ -14,15 +24,69 @@ bool Workspace::WorkspacePage::BubbleInUse(qlonglong bubble_id) {
 }
 
 bool Workspace::WorkspacePage::BubbleDeleted(qlonglong bubble_id) {
-  QSqlQuery query;
-  return Sql::ExecParam(
-        &query,
+  SqlExecutor::EnqueueParam(
         "UPDATE workspace_page SET bubble_id = -1 WHERE bubble_id = ?",
-        { bubble_id });
+        { bubble_id }, { "workspace_page" });
+  return true;
+}
+
+void Workspace::WorkspacePage::FlushPendingUpdates() {
+  if (pending_updates_timer_) pending_updates_timer_->stop();
+  if (pending_updates_.isEmpty() && pending_deletes_.isEmpty() &&
+      keys_to_forget_.isEmpty()) {
+    return;
+  }
+  auto updates = pending_updates_;
+  pending_updates_.clear();
+  auto deletes = pending_deletes_;
+  pending_deletes_.clear();
+  // The writer runs this in a single transaction
+  SqlExecutor::Enqueue([updates, deletes](QSqlQuery* query) -> QVariant {
+    auto ok = true;
+    if (!deletes.isEmpty()) {
+      ok = Sql::Prepare(query, "DELETE FROM workspace_page WHERE id = ?");
+      for (auto key : deletes) {
+        if (!ok) break;
+        auto id = SqlExecutor::ResolveKey(key);
+        // Insert failed, nothing to delete
+        if (id < 0) continue;
+        query->addBindValue(id);
+        ok = Sql::Exec(query);
+      }
+    }
+    for (auto it = updates.constBegin(); it != updates.constEnd(); it++) {
+      auto id = SqlExecutor::ResolveKey(it.key());
+      if (id < 0) continue;
+      QStringList sets;
+      QVariantList params;
+      for (auto col = it->constBegin(); col != it->constEnd(); col++) {
+        sets << col.key() + " = ?";
+        // Favicons are held as images until here
+        if (col.key() == "favicon_id") {
+          params << FaviconStore::Id(query, col.value().value<QImage>());
+        } else if (col.key() == "parent_id") {
+          params << ResolveParentKey(col.value());
+        } else {
+          params << col.value();
+        }
+      }
+      params << id;
+      ok = Sql::ExecParam(query,
+                          "UPDATE workspace_page SET " + sets.join(", ") +
+                          " WHERE id = ?",
+                          params) && ok;
+    }
+    return ok ? QVariant(true) : QVariant();
+  }, { "workspace_page", "favicon" });
+  for (auto key : keys_to_forget_) SqlExecutor::ForgetKey(key);
+  keys_to_forget_.clear();
 }
 
 Workspace::WorkspacePage::WorkspacePage(qlonglong id) {
   if (id < 0) return;
+  // Held updates and deletes have to land first
+  FlushPendingUpdates();
+  SqlExecutor::WaitFor("workspace_page");
   QSqlQuery query;
   FromRecord(Sql::ExecSingleParam(
                &query,
@@ -34,71 +98,135 @@ Workspace::WorkspacePage::WorkspacePage(const QSqlRecord& record) {
   FromRecord(record);
 }
 
+qlonglong Workspace::WorkspacePage::Id() const {
+  if (pending_id_.valid()) {
+    auto id = pending_id_.get();
+    id_ = id.isValid() ? id.toLongLong() : -1;
+    pending_id_ = SqlExecutor::Result();
+  }
+  return id_;
+}
+
+qlonglong Workspace::WorkspacePage::Key() const {
+  if (key_ < -1 && pending_id_.valid() &&
+      pending_id_.wait_for(std::chrono::seconds(0)) ==
+          std::future_status::ready) {
+    auto key = key_;
+    key_ = -1;
+    auto id = Id();
+    // Held ones move over, newer values win
+    auto updates = pending_updates_.take(key);
+    if (id >= 0 && !updates.isEmpty()) {
+      auto& columns = pending_updates_[id];
+      for (auto it = updates.constBegin(); it != updates.constEnd(); it++) {
+        if (!columns.contains(it.key())) columns[it.key()] = it.value();
+      }
+    }
+    if (pending_deletes_.remove(key) && id >= 0) pending_deletes_.insert(id);
+    keys_to_forget_.insert(key);
+    StartPendingUpdatesTimer();
+  }
+  return key_ < -1 ? key_ : id_;
+}
+
 QIcon Workspace::WorkspacePage::Icon() {
-  if (icon_.isNull() && !serialized_icon_.isNull()) {
+  if (icon_.isNull() && !favicon_id_.isNull()) {
+    icon_ = FaviconStore::Icon(favicon_id_);
+  } else if (icon_.isNull() && !legacy_icon_.isNull()) {
     // TODO(cretz): handle failure w/ transparent 16x16
     QPixmap pixmap;
-    pixmap.loadFromData(serialized_icon_, "PNG");
+    pixmap.loadFromData(legacy_icon_, "PNG");
     icon_ = QIcon(pixmap);
+    legacy_icon_.clear();
+    dirty_ |= IconField;
   }
   return icon_;
 }
 
 void Workspace::WorkspacePage::SetIcon(const QIcon& icon) {
+  if (icon.cacheKey() == icon_.cacheKey()) return;
   icon_ = icon;
-  // TODO(cretz): Find a better way to determine the icon is dirty,
-  //  maybe store the URL? But some favicons change
-  serialized_icon_.clear();
+  dirty_ |= IconField;
+  legacy_icon_.clear();
 }
 
 bool Workspace::WorkspacePage::Persist() {
-  // If serialized icon is not there but an icon is, we create it
-  if (serialized_icon_.isNull() && !icon_.isNull()) {
-    QBuffer buffer(&serialized_icon_);
-    buffer.open(QIODevice::WriteOnly);
-    icon_.pixmap(16, 16).save(&buffer, "PNG");
-  }
-  QSqlQuery query;
-  QVariant parent_id = parent_id_ < 0 ?
+  QVariant parent_id = parent_id_ == -1 ?
         QVariant(QVariant::LongLong) : parent_id_;
   if (Exists()) {
-    return Sql::ExecParam(
-          &query,
-          "UPDATE workspace_page SET "
-          " workspace_id = ?, "
-          " parent_id = ?, "
-          " pos = ?, "
-          " icon = ?, "
-          " title = ?, "
-          " url = ?, "
-          " bubble_id = ?, "
-          " suspended = ?, "
-          " expanded = ? "
-          "WHERE id = ?",
-          { workspace_id_, parent_id, pos_, serialized_icon_,
-            title_, url_, bubble_id_, suspended_, expanded_, id_ });
+    if (dirty_ == 0) return true;
+    auto& columns = pending_updates_[Key()];
+    if (dirty_ & WorkspaceIdField) columns["workspace_id"] = workspace_id_;
+    if (dirty_ & ParentIdField) columns["parent_id"] = parent_id;
+    if (dirty_ & PosField) columns["pos"] = pos_;
+    if (dirty_ & IconField) {
+      // Resolved to an ID on flush
+      columns["favicon_id"] =
+          QVariant::fromValue(FaviconStore::ImageFromIcon(icon_));
+      columns["icon"] = QVariant(QVariant::ByteArray);
+    }
+    if (dirty_ & TitleField) columns["title"] = title_;
+    if (dirty_ & UrlField) columns["url"] = url_;
+    if (dirty_ & BubbleIdField) columns["bubble_id"] = bubble_id_;
+    if (dirty_ & SuspendedField) columns["suspended"] = suspended_;
+    if (dirty_ & ExpandedField) columns["expanded"] = expanded_;
+    dirty_ = 0;
+    StartPendingUpdatesTimer();
+    return true;
   }
-  auto ok = Sql::ExecParam(
-      &query,
-      "INSERT INTO workspace_page ( "
-      "   workspace_id, parent_id, pos, icon, "
-      "   title, url, bubble_id, suspended, expanded "
-      ") VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)",
-      { workspace_id_, parent_id, pos_, serialized_icon_,
-        title_, url_, bubble_id_, suspended_, expanded_ });
-  if (!ok) return false;
-  id_ = query.lastInsertId().toLongLong();
+  auto image = FaviconStore::ImageFromIcon(Icon());
+  auto key = SqlExecutor::NewKey();
+  QVariantList params = { workspace_id_, pos_, title_, url_,
+                          bubble_id_, suspended_, expanded_ };
+  pending_id_ = SqlExecutor::Enqueue([=](QSqlQuery* query) -> QVariant {
+    // The parent may have been inserted just before us
+    auto all_params = params;
+    all_params.insert(1, ResolveParentKey(parent_id));
+    all_params << FaviconStore::Id(query, image);
+    auto ok = Sql::ExecParam(
+        query,
+        "INSERT INTO workspace_page ( "
+        "   workspace_id, parent_id, pos, title, url, "
+        "   bubble_id, suspended, expanded, favicon_id "
+        ") VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)",
+        all_params);
+    auto id = ok ? query->lastInsertId().toLongLong() : -1;
+    SqlExecutor::MapKey(key, id);
+    if (!ok) return QVariant();
+    return id;
+  }, { "workspace_page", "favicon" });
+  key_ = key;
+  dirty_ = 0;
   return true;
 }
 
 bool Workspace::WorkspacePage::Delete() {
-  if (id_ < 0) return false;
-  QSqlQuery query;
-  auto ok = Sql::ExecParam(&query,
-                           "DELETE FROM workspace_page WHERE id = ?",
-                           { id_ });
-  if (ok) id_ = -1;
-  return ok;
+  if (!Exists()) return false;
+  pending_updates_.remove(Key());
+  pending_deletes_.insert(Key());
+  StartPendingUpdatesTimer();
+  id_ = -1;
+  pending_id_ = SqlExecutor::Result();
+  key_ = -1;
+  return true;
+}
+
+void Workspace::WorkspacePage::StartPendingUpdatesTimer() {
+  if (!pending_updates_timer_) {
+    pending_updates_timer_ = new QTimer;
+    pending_updates_timer_->setSingleShot(true);
+    pending_updates_timer_->setInterval(kPersistDebounceMs);
+    QObject::connect(pending_updates_timer_, &QTimer::timeout,
+                     &WorkspacePage::FlushPendingUpdates);
+  }
+  if (!pending_updates_timer_->isActive()) pending_updates_timer_->start();
+}
+
+QVariant Workspace::WorkspacePage::ResolveParentKey(
+    const QVariant& parent_key) {
+  if (parent_key.isNull()) return parent_key;
+  auto id = SqlExecutor::ResolveKey(parent_key.toLongLong());
+  return id < 0 ? QVariant(QVariant::LongLong) : id;
 }
 
 void Workspace::WorkspacePage::FromRecord(const QSqlRecord& record) {
@@ -108,7 +236,8 @@ void Workspace::WorkspacePage::FromRecord(const QSqlRecord& record) {
   parent_id_ = record.isNull("parent_id") ?
         -1 : record.value("parent_id").toLongLong();
   pos_ = record.value("pos").toInt();
-  serialized_icon_ = record.value("icon").toByteArray();
+  favicon_id_ = record.value("favicon_id");
+  legacy_icon_ = record.value("icon").toByteArray();
   title_ = record.value("title").toString();
   url_ = record.value("url").toString();
   bubble_id_ = record.value("bubble_id").toLongLong();
@@ -224,6 +353,12 @@ bool Workspace::Persist() {
 
 bool Workspace::Delete() {
   if (id_ < 0) return false;
+  // Queued page writes would otherwise land after we delete
+  WorkspacePage::FlushPendingUpdates();
+  SqlExecutor::WaitFor("workspace_page");
+  for (const auto& page : AllChildren()) {
+    ScreenshotCache::Remove(page.Id());
+  }
   // Delete children first
   QSqlDatabase::database().transaction();
   QSqlQuery query;
@@ -246,6 +381,8 @@ bool Workspace::Delete() {
 
 QList<Workspace::WorkspacePage> Workspace::AllChildren() const {
   QList<Workspace::WorkspacePage> ret;
+  WorkspacePage::FlushPendingUpdates();
+  SqlExecutor::WaitFor("workspace_page");
   QSqlQuery query;
   auto ok = Sql::ExecParam(
         &query,
@@ -261,6 +398,8 @@ QList<Workspace::WorkspacePage> Workspace::AllChildren() const {
 QList<Workspace::WorkspacePage> Workspace::ChildrenOf(
     qlonglong parent_id) const {
   QList<Workspace::WorkspacePage> ret;
+  WorkspacePage::FlushPendingUpdates();
+  SqlExecutor::WaitFor("workspace_page");
   QSqlQuery query;
   auto ok = Sql::ExecParam(
         &query,
@@ -4,6 +4,8 @@
 #include <QtSql>
 #include <QtWidgets>
 
+#include "sql_executor.h"
+
 namespace doogie {
 
 // DB model for a workspace.
@@ -11,54 +13,122 @@ class Workspace {
  public:
   class WorkspacePage {
    public:
+    // Updates are held this long to be written together
+    static const int kPersistDebounceMs = 300;
+
     static bool BubbleInUse(qlonglong bubble_id);
     static bool BubbleDeleted(qlonglong bubble_id);
+    // Writes all held updates now, e.g. on shutdown
+    static void FlushPendingUpdates();
 
     explicit WorkspacePage(qlonglong id = -1);
     explicit WorkspacePage(const QSqlRecord& record);
 
     qlonglong WorkspaceId() const { return workspace_id_; }
     void SetWorkspaceId(qlonglong workspace_id) {
-      workspace_id_ = workspace_id;
+      SetField(&workspace_id_, workspace_id, WorkspaceIdField);
     }
 
-    bool Exists() const { return id_ >= 0; }
-    qlonglong Id() const { return id_; }
-
+    bool Exists() const { return id_ >= 0 || key_ < -1; }
+    // Never waits. The ID, or for pages inserted this run, the writer key
+    //  it gets turned into once the insert is done. Anything written about
+    //  the page, including it being another page's parent, uses this.
+    //  Once the insert is done, this gives the ID and the key is let go.
+    qlonglong Key() const;
+    // Note, this waits on the writer if the insert is still queued. Only
+    //  for things that live outside the DB, e.g. screenshots.
+    qlonglong Id() const;
+    // Never waits, -1 if Id would
+    qlonglong KnownId() const { return pending_id_.valid() ? -1 : id_; }
+
+    // May be a key, see Key
     qlonglong ParentId() const { return parent_id_; }
-    void SetParentId(qlonglong parent_id) { parent_id_ = parent_id; }
+    void SetParentId(qlonglong parent_id) {
+      SetField(&parent_id_, parent_id, ParentIdField);
+    }
 
     int Pos() const { return pos_; }
-    void SetPos(int pos) { pos_ = pos; }
+    void SetPos(int pos) { SetField(&pos_, pos, PosField); }
 
     // This is not const because it is created lazily as needed
     QIcon Icon();
     void SetIcon(const QIcon& icon);
 
     QString Title() const { return title_; }
-    void SetTitle(const QString& title) { title_ = title; }
+    void SetTitle(const QString& title) {
+      SetField(&title_, title, TitleField);
+    }
     QString Url() const { return url_; }
-    void SetUrl(const QString& url) { url_ = url; }
+    void SetUrl(const QString& url) { SetField(&url_, url, UrlField); }
     qlonglong BubbleId() const { return bubble_id_; }
-    void SetBubbleId(qlonglong bubble_id) { bubble_id_ = bubble_id; }
+    void SetBubbleId(qlonglong bubble_id) {
+      SetField(&bubble_id_, bubble_id, BubbleIdField);
+    }
     bool Suspended() const { return suspended_; }
-    void SetSuspended(bool suspended) { suspended_ = suspended; }
+    void SetSuspended(bool suspended) {
+      SetField(&suspended_, suspended, SuspendedField);
+    }
     bool Expanded() const { return expanded_; }
-    void SetExpanded(bool expanded) { expanded_ = expanded; }
+    void SetExpanded(bool expanded) {
+      SetField(&expanded_, expanded, ExpandedField);
+    }
 
+    // New pages are inserted right away, but updates to existing pages
+    //  only write the changed fields and are held briefly so they can be
+    //  written with others. Either way, they are queued on the writer so
+    //  false only means it could not even be queued.
     bool Persist();
-    // Automatically deletes children
+    // Held and written together w/ the updates
     bool Delete();
 
    private:
+    enum Field {
+      WorkspaceIdField = 0x1,
+      ParentIdField = 0x2,
+      PosField = 0x4,
+      IconField = 0x8,
+      TitleField = 0x10,
+      UrlField = 0x20,
+      BubbleIdField = 0x40,
+      SuspendedField = 0x80,
+      ExpandedField = 0x100
+    };
+
+    // Keyed by page key, values are column name to value
+    static QHash<qlonglong, QVariantHash> pending_updates_;
+    static QSet<qlonglong> pending_deletes_;
+    // Let go of after the next flush, since held updates (e.g. of child
+    //  pages' parent) may still use them
+    static QSet<qlonglong> keys_to_forget_;
+    static QTimer* pending_updates_timer_;
+
+    template<typename T>
+    void SetField(T* field, const T& value, Field flag) {
+      if (*field == value) return;
+      *field = value;
+      dirty_ |= flag;
+    }
+
+    static void StartPendingUpdatesTimer();
+    // Only on the writer, null for none
+    static QVariant ResolveParentKey(const QVariant& parent_key);
+
     void FromRecord(const QSqlRecord& record);
 
+    int dirty_ = 0;
     qlonglong workspace_id_ = -1;
-    qlonglong id_ = -1;
+    // Mutable because they are resolved lazily once the insert is done
+    mutable qlonglong id_ = -1;
+    mutable SqlExecutor::Result pending_id_;
+    // Less than -1 if inserted this run and the ID isn't known yet
+    mutable qlonglong key_ = -1;
     qlonglong parent_id_ = -1;
     int pos_ = 0;
     QIcon icon_;
-    QByteArray serialized_icon_;
+    // Null if none
+    QVariant favicon_id_;
+    // From before there was a favicon store, moved over on next persist
+    QByteArray legacy_icon_;
     QString title_ = "";
     QString url_ = "";
     qlonglong bubble_id_ = -1;
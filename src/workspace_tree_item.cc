@@ -9,6 +9,9 @@ WorkspaceTreeItem::WorkspaceTreeItem(const Workspace& workspace)
   setFlags(Qt::ItemIsEditable | Qt::ItemIsDragEnabled |
            Qt::ItemIsDropEnabled | Qt::ItemIsEnabled);
   setText(0, workspace.FriendlyName());
+  // The tree opens the menu when this is clicked
+  setIcon(PageTreeItem::kCloseButtonColumn,
+          Util::CachedIcon(":/res/images/fontawesome/bars.png"));
 }
 
 WorkspaceTreeItem::~WorkspaceTreeItem() {
@@ -18,21 +21,7 @@ WorkspaceTreeItem::~WorkspaceTreeItem() {
 }
 
 void WorkspaceTreeItem::AfterAdded() {
-  auto menu_button = new QToolButton;
-  menu_button->setIcon(
-        Util::CachedIcon(":/res/images/fontawesome/bars.png"));
-  menu_button->setAutoRaise(true);
-  treeWidget()->connect(menu_button, &QToolButton::clicked, [=]() {
-    auto tree = static_cast<PageTree*>(treeWidget());
-    QMenu menu;
-    tree->ApplyWorkspaceMenu(&menu, workspace_, this);
-    menu.exec(menu_button->mapToGlobal(menu_button->rect().bottomLeft()));
-  });
-  treeWidget()->setItemWidget(this,
-                              PageTreeItem::kCloseButtonColumn,
-                              menu_button);
-
-  // Gotta call it on my children too sadly
+  // Children need to know their new workspace
   for (int i = 0; i < childCount(); i++) {
     static_cast<PageTreeItem*>(child(i))->AfterAdded();
   }